@@ -0,0 +1,252 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Daisuke Itabashi (https://github.com/idaisuke/ferrum)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Benchmark and contention harness for the container subsystem.
+//
+// ferrum is header-only and ships no build manifest, so this harness is
+// self-contained and depends only on the standard library:
+//
+//     g++ -std=c++14 -O2 -I../include container_benchmark.cc -o container_benchmark -pthread
+//     ./container_benchmark            # full run, element counts up to 1M
+//     ./container_benchmark --quick    # small element counts only
+//
+// Each benchmark reports throughput, mean and p99 per-operation latency, and
+// bytes allocated per operation (counted with a global operator new hook), for
+// the mutator families push_back, replace_all_if, sort and swap, over trivially
+// copyable (int) and non-trivial (std::string) elements, and for reader/writer
+// thread mixes from 1 writer / 0 readers up to 4 writers / 60 readers.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <ferrum/container/copy_on_write_vector.h>
+
+namespace {
+
+    std::atomic<std::uint64_t> allocated_bytes(0);
+}
+
+void *operator new(std::size_t size) {
+    allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (auto ptr = std::malloc(size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+namespace {
+
+    using clock_type = std::chrono::steady_clock;
+
+    double to_micros(clock_type::duration duration) {
+        return std::chrono::duration_cast<std::chrono::duration<double, std::micro>>(duration).count();
+    }
+
+    /**
+     *  Runs op() iteration times, recording one latency sample per call, and prints
+     *  throughput, mean, p99 and bytes allocated per op on a single line.
+     */
+    template <class Operation>
+    void run(const char *name, std::size_t iterations, Operation op) {
+        std::vector<double> samples;
+        samples.reserve(iterations);
+        auto bytes_before = allocated_bytes.load(std::memory_order_relaxed);
+        auto begin = clock_type::now();
+        for (std::size_t i = 0; i < iterations; ++i) {
+            auto start = clock_type::now();
+            op(i);
+            samples.push_back(to_micros(clock_type::now() - start));
+        }
+        auto elapsed = to_micros(clock_type::now() - begin);
+        auto bytes = allocated_bytes.load(std::memory_order_relaxed) - bytes_before;
+
+        std::sort(samples.begin(), samples.end());
+        double mean = 0;
+        for (auto sample : samples) {
+            mean += sample;
+        }
+        mean /= samples.size();
+        auto p99 = samples[samples.size() * 99 / 100];
+
+        std::printf("%-48s %12.0f ops/s  mean %10.3f us  p99 %10.3f us  %10.1f B/op\n", name,
+                    iterations / elapsed * 1e6, mean, p99, static_cast<double>(bytes) / iterations);
+    }
+
+    template <class T>
+    T make_element(std::size_t i);
+
+    template <>
+    int make_element<int>(std::size_t i) {
+        return static_cast<int>(i);
+    }
+
+    template <>
+    std::string make_element<std::string>(std::size_t i) {
+        return "element-" + std::to_string(i) + "-padding-padding-padding";
+    }
+
+    /**
+     *  Single-threaded mutator families at the given element count.
+     */
+    template <class T>
+    void bench_mutators(const char *type_name, std::size_t count) {
+        char name[128];
+        std::size_t iterations = std::max<std::size_t>(std::size_t(1000000) / count, 4);
+
+        {
+            fe::copy_on_write_vector<T> vec;
+            std::snprintf(name, sizeof(name), "push_back/%s/%zu", type_name, count);
+            run(name, count, [&](std::size_t i) { vec.push_back(make_element<T>(i)); });
+        }
+        {
+            fe::copy_on_write_vector<T> vec;
+            for (std::size_t i = 0; i < count; ++i) {
+                vec.push_back(make_element<T>(i));
+            }
+            std::snprintf(name, sizeof(name), "push_back/%s/%zu/snapshot_held", type_name, count);
+            auto snapshot = vec.lock();
+            run(name, iterations, [&](std::size_t i) { vec.push_back(make_element<T>(i)); });
+        }
+        {
+            fe::copy_on_write_vector<T> vec;
+            for (std::size_t i = 0; i < count; ++i) {
+                vec.push_back(make_element<T>(i));
+            }
+            auto needle = make_element<T>(count / 2);
+            auto replacement = make_element<T>(count / 2 + 1);
+            std::snprintf(name, sizeof(name), "replace_all_if/%s/%zu", type_name, count);
+            run(name, iterations, [&](std::size_t) {
+                vec.replace_all_if([&](const T &elem) { return elem == needle; }, replacement);
+            });
+        }
+        {
+            fe::copy_on_write_vector<T> vec;
+            for (std::size_t i = 0; i < count; ++i) {
+                vec.push_back(make_element<T>(count - i));
+            }
+            std::snprintf(name, sizeof(name), "sort/%s/%zu", type_name, count);
+            run(name, std::max<std::size_t>(iterations / 4, 2), [&](std::size_t) { vec.sort(); });
+        }
+        {
+            fe::copy_on_write_vector<T> vec;
+            fe::copy_on_write_vector<T> other;
+            for (std::size_t i = 0; i < count; ++i) {
+                vec.push_back(make_element<T>(i));
+            }
+            std::snprintf(name, sizeof(name), "swap/%s/%zu", type_name, count);
+            run(name, iterations, [&](std::size_t) { vec.swap(other); });
+        }
+    }
+
+    /**
+     *  Writers appending and replacing against readers scanning snapshots, at the
+     *  given thread mix. Reports the writer-side per-op numbers; reader progress is
+     *  printed as a total so reader starvation is visible.
+     */
+    void bench_contention(std::size_t writer_count, std::size_t reader_count, std::size_t count) {
+        fe::copy_on_write_vector<int> vec;
+        for (std::size_t i = 0; i < count; ++i) {
+            vec.push_back(static_cast<int>(i));
+        }
+
+        std::atomic<bool> stop(false);
+        std::atomic<std::uint64_t> reads(0);
+        std::vector<std::thread> readers;
+        for (std::size_t r = 0; r < reader_count; ++r) {
+            readers.emplace_back([&] {
+                while (!stop.load(std::memory_order_relaxed)) {
+                    auto snapshot = vec.lock();
+                    std::uint64_t sum = 0;
+                    for (auto elem : snapshot) {
+                        sum += static_cast<std::uint64_t>(elem);
+                    }
+                    reads.fetch_add(1, std::memory_order_relaxed);
+                    (void)sum;
+                }
+            });
+        }
+
+        std::size_t iterations = std::max<std::size_t>(std::size_t(200000) / count, 8);
+        char name[128];
+        std::snprintf(name, sizeof(name), "contention/%zuw/%zur/%zu", writer_count, reader_count, count);
+
+        std::vector<std::thread> writers;
+        for (std::size_t w = 1; w < writer_count; ++w) {
+            writers.emplace_back([&] {
+                for (std::size_t i = 0; i < iterations; ++i) {
+                    vec.replace_all_if([](int elem) { return elem % 1024 == 0; }, 0);
+                }
+            });
+        }
+        run(name, iterations, [&](std::size_t) {
+            vec.replace_all_if([](int elem) { return elem % 1024 == 1; }, 1);
+        });
+        for (auto &writer : writers) {
+            writer.join();
+        }
+
+        stop.store(true);
+        for (auto &reader : readers) {
+            reader.join();
+        }
+        if (reader_count > 0) {
+            std::printf("%-48s %12llu reader scans\n", "  ", static_cast<unsigned long long>(reads.load()));
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    bool quick = argc > 1 && std::strcmp(argv[1], "--quick") == 0;
+
+    std::vector<std::size_t> counts = {1000, 100000};
+    if (!quick) {
+        counts.push_back(1000000);
+    }
+
+    for (auto count : counts) {
+        bench_mutators<int>("int", count);
+        bench_mutators<std::string>("string", count);
+    }
+
+    std::vector<std::pair<std::size_t, std::size_t>> mixes = {{1, 0}, {1, 4}, {1, 16}, {2, 30}, {4, 60}};
+    for (auto mix : mixes) {
+        bench_contention(mix.first, mix.second, quick ? 1000 : 100000);
+    }
+
+    return 0;
+}
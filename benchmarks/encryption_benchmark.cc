@@ -0,0 +1,170 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Daisuke Itabashi (https://github.com/idaisuke/ferrum)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Benchmark and concurrency stress for the encryption subsystem.
+//
+// Self-contained like container_benchmark.cc:
+//
+//     g++ -std=c++14 -O2 -I../include encryption_benchmark.cc -o encryption_benchmark -pthread -lcrypto
+//     g++ -std=c++14 -O2 -mavx2 -maes ...      # exercises the AES-NI and AVX2 paths
+//
+// Reports single-value encrypt/decrypt latency for xor_cipher (int and float
+// paths) and aes_cipher, bulk span throughput in MB/s through the encrypt_n /
+// decrypt_n kernels and the encrypt_range/decrypt_range API, and runs a
+// 32-thread cipher construction stress against the per-thread key engines.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include <ferrum/encryption/aes_cipher_value.h>
+#include <ferrum/encryption/xor_cipher_value.h>
+
+namespace {
+
+    using clock_type = std::chrono::steady_clock;
+
+    double seconds_since(clock_type::time_point start) {
+        return std::chrono::duration_cast<std::chrono::duration<double>>(clock_type::now() - start).count();
+    }
+
+    /**
+     *  Runs op() iteration times and prints the mean per-call latency.
+     */
+    template <class Operation>
+    void bench_latency(const char *name, std::size_t iterations, Operation op) {
+        auto start = clock_type::now();
+        for (std::size_t i = 0; i < iterations; ++i) {
+            op(i);
+        }
+        auto elapsed = seconds_since(start);
+        std::printf("%-40s %10.2f ns/op  %12.0f ops/s\n", name, elapsed / iterations * 1e9, iterations / elapsed);
+    }
+
+    /**
+     *  Runs op() repetition times over payload_bytes of data and prints MB/s.
+     */
+    template <class Operation>
+    void bench_throughput(const char *name, std::size_t repetitions, std::size_t payload_bytes, Operation op) {
+        auto start = clock_type::now();
+        for (std::size_t i = 0; i < repetitions; ++i) {
+            op();
+        }
+        auto elapsed = seconds_since(start);
+        std::printf("%-40s %10.1f MB/s\n", name,
+                    static_cast<double>(payload_bytes) * repetitions / elapsed / (1024.0 * 1024.0));
+    }
+
+    template <class T, template <class> class Cipher>
+    void bench_single(const char *name) {
+        Cipher<T> cipher;
+        volatile T sink = T();
+        char label[64];
+        std::snprintf(label, sizeof(label), "%s/encrypt", name);
+        bench_latency(label, 2000000, [&](std::size_t i) { sink = cipher.decrypt(cipher.encrypt(static_cast<T>(i))); });
+        (void)sink;
+    }
+
+    template <class T, template <class> class Cipher>
+    void bench_bulk(const char *name, std::size_t count) {
+        Cipher<T> cipher;
+        std::vector<T> in(count), back(count);
+        std::vector<typename Cipher<T>::encrypted_type> out(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            in[i] = static_cast<T>(i);
+        }
+        char label[64];
+        std::snprintf(label, sizeof(label), "%s/encrypt_n/%zu", name, count);
+        bench_throughput(label, 2000, count * sizeof(T), [&] { cipher.encrypt_n(in.data(), count, out.data()); });
+        std::snprintf(label, sizeof(label), "%s/decrypt_n/%zu", name, count);
+        bench_throughput(label, 2000, count * sizeof(T), [&] { cipher.decrypt_n(out.data(), count, back.data()); });
+    }
+
+    template <class T, template <class> class Cipher>
+    void bench_range(const char *name, std::size_t count) {
+        std::vector<T> in(count), out(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            in[i] = static_cast<T>(i);
+        }
+        std::vector<fe::cipher_value<T, Cipher>> values(count);
+        char label[64];
+        std::snprintf(label, sizeof(label), "%s/encrypt_range/%zu", name, count);
+        bench_throughput(label, 200, count * sizeof(T), [&] { fe::encrypt_range(in.data(), count, values.data()); });
+        std::snprintf(label, sizeof(label), "%s/decrypt_range/%zu", name, count);
+        bench_throughput(label, 200, count * sizeof(T), [&] { fe::decrypt_range(values.data(), count, out.data()); });
+    }
+
+    /**
+     *  Constructs cipher values from many threads at once; any data race in the key
+     *  engine holders shows up here under a sanitizer, and the wall time shows whether
+     *  construction scales instead of serializing.
+     */
+    void stress_construction(std::size_t thread_count, std::size_t per_thread) {
+        std::atomic<std::size_t> failures(0);
+        auto start = clock_type::now();
+        std::vector<std::thread> workers;
+        for (std::size_t t = 0; t < thread_count; ++t) {
+            workers.emplace_back([&failures, per_thread] {
+                for (std::size_t i = 0; i < per_thread; ++i) {
+                    fe::xor_cipher_value<int> value(static_cast<int>(i));
+                    if (static_cast<int>(value) != static_cast<int>(i)) {
+                        failures.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    fe::xor_cipher_value<float> real(static_cast<float>(i));
+                    if (static_cast<float>(real) != static_cast<float>(i)) {
+                        failures.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+            });
+        }
+        for (auto &worker : workers) {
+            worker.join();
+        }
+        auto elapsed = seconds_since(start);
+        std::printf("construction_stress/%zut/%zu per thread: %.3f s, %zu failures\n", thread_count, per_thread,
+                    elapsed, failures.load());
+    }
+}
+
+int main() {
+    bench_single<int, fe::xor_cipher>("xor/int");
+    bench_single<long long, fe::xor_cipher>("xor/int64");
+    bench_single<float, fe::xor_cipher>("xor/float");
+    bench_single<double, fe::xor_cipher>("xor/double");
+    bench_single<int, fe::aes_cipher>("aes/int");
+    bench_single<long long, fe::aes_cipher>("aes/int64");
+
+    bench_bulk<int, fe::xor_cipher>("xor/int", 65536);
+    bench_bulk<long long, fe::xor_cipher>("xor/int64", 65536);
+    bench_bulk<float, fe::xor_cipher>("xor/float", 65536);
+    bench_bulk<double, fe::xor_cipher>("xor/double", 65536);
+
+    bench_range<int, fe::xor_cipher>("xor/int", 65536);
+    bench_range<float, fe::xor_cipher>("xor/float", 65536);
+    bench_range<int, fe::aes_cipher>("aes/int", 8192);
+
+    stress_construction(32, 50000);
+
+    return 0;
+}
@@ -0,0 +1,317 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Daisuke Itabashi (https://github.com/idaisuke/ferrum)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef __ferrum__async_copy_on_write_vector__
+#define __ferrum__async_copy_on_write_vector__
+
+#include <condition_variable>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "copy_on_write_vector.h"
+
+namespace fe {
+
+    /**
+     *  Represents a write-behind front for fe::copy_on_write_vector.
+     *  Mutators enqueue the operation and return immediately instead of copying the
+     *  underlying container on the calling thread; a dedicated publisher thread owned
+     *  by this container drains the queue and applies each drained batch through a
+     *  single batch_update, so consecutive operations are coalesced into one copy and
+     *  one publication, and the copy cost never lands on a latency-sensitive writer.
+     *
+     *  Reads go to the underlying container and see the last published version, which
+     *  may not yet include operations still sitting in the queue; call flush() where
+     *  a writer needs to observe its own writes.
+     *
+     *  The queued operations run on the publisher thread and must not throw.
+     *
+     *  ~~~~~~~~~~
+     *  fe::async_copy_on_write_vector<int> vec = {2, 3, 5, 7};
+     *
+     *  vec.push_back(11);   // returns before any copy is made
+     *  vec.flush();         // waits until every queued operation is published
+     *
+     *  auto snapshot = vec.lock();
+     *  ~~~~~~~~~~
+     *
+     *  @tparam T         The type of the elements
+     *  @tparam Allocator An allocator that is used to acquire memory to store the elements
+     *  @tparam Container The type of the underlying container that holds one version of the
+     *                    elements
+     */
+    template <class T, class Allocator = std::allocator<T>, class Container = std::vector<T, Allocator>>
+    class async_copy_on_write_vector {
+    public:
+        /**
+         *  The type of the underlying thread-safe container.
+         */
+        using vector_type = copy_on_write_vector<T, Allocator, Container>;
+
+        /**
+         *  The type of the underlying container that holds one version of the elements.
+         */
+        using container_type = typename vector_type::container_type;
+
+        /**
+         *  The type of the elements.
+         */
+        using value_type = typename vector_type::value_type;
+
+        /**
+         *  The type of the allocator.
+         */
+        using allocator_type = typename vector_type::allocator_type;
+
+        /**
+         *  The unsigned integral type of the size of the underlying container.
+         */
+        using size_type = typename vector_type::size_type;
+
+        /**
+         *  The type of the constant reference of the elements.
+         */
+        using const_reference = typename vector_type::const_reference;
+
+        /**
+         *  The type of the snapshot of the underlying container.
+         */
+        using snapshot = typename vector_type::snapshot;
+
+        /**
+         *  The type of the pinned read view of the underlying container.
+         */
+        using pinned_snapshot = typename vector_type::pinned_snapshot;
+
+        /**
+         *  Default constructor. Constructs an empty container and starts the publisher
+         *  thread.
+         */
+        async_copy_on_write_vector() : async_copy_on_write_vector(allocator_type()) {
+        }
+
+        /**
+         *  Constructs an empty container and starts the publisher thread.
+         *
+         *  @param allocator The user supplied allocator.
+         */
+        explicit async_copy_on_write_vector(const allocator_type &allocator) : _vector(allocator), _pending(0),
+                                                                               _stopped(false) {
+            _publisher = std::thread([this] { run(); });
+        }
+
+        /**
+         *  Constructs the container with the contents of the initializer list and starts
+         *  the publisher thread.
+         *
+         *  @param initializer_list The initializer list to initialize the elements of the container with.
+         */
+        async_copy_on_write_vector(std::initializer_list<value_type> initializer_list)
+            : _vector(std::move(initializer_list)), _pending(0), _stopped(false) {
+            _publisher = std::thread([this] { run(); });
+        }
+
+        async_copy_on_write_vector(const async_copy_on_write_vector &) = delete;
+        async_copy_on_write_vector &operator=(const async_copy_on_write_vector &) = delete;
+
+        /**
+         *  Publishes every queued operation, then stops and joins the publisher thread.
+         */
+        ~async_copy_on_write_vector() {
+            {
+                std::lock_guard<std::mutex> lock(_queue_mutex);
+                _stopped = true;
+            }
+            _ready.notify_all();
+            _publisher.join();
+        }
+
+        /**
+         *  Enqueues the given mutation and returns immediately.
+         *  The publisher thread applies it to a copy of the underlying container together
+         *  with every other operation drained in the same batch, so a burst of updates
+         *  costs a single copy and publication.
+         *
+         *  @param fn The function that applies the mutation to the copied container.
+         */
+        template <class UnaryFunction>
+        void batch_update(UnaryFunction fn) {
+            {
+                std::lock_guard<std::mutex> lock(_queue_mutex);
+                _queue.emplace_back(std::move(fn));
+                ++_pending;
+            }
+            _ready.notify_one();
+        }
+
+        /**
+         *  Enqueues appending the given value and returns immediately.
+         *
+         *  @param value The value to append.
+         */
+        void push_back(const_reference value) {
+            batch_update([value](container_type &container) { container.push_back(value); });
+        }
+
+        /**
+         *  Enqueues appending the given value using move semantics and returns immediately.
+         *
+         *  @param value The value to append.
+         */
+        void push_back(value_type &&value) {
+            auto moved = std::make_shared<value_type>(std::move(value));
+            batch_update([moved](container_type &container) { container.push_back(std::move(*moved)); });
+        }
+
+        /**
+         *  Enqueues removing the last element and returns immediately.
+         *  The removal applies to the container as of publication time; an empty container
+         *  at that point is left unchanged rather than invoking undefined behaviour on the
+         *  publisher thread.
+         */
+        void pop_back() {
+            batch_update([](container_type &container) {
+                if (!container.empty()) {
+                    container.pop_back();
+                }
+            });
+        }
+
+        /**
+         *  Enqueues removing all elements and returns immediately.
+         */
+        void clear() {
+            batch_update([](container_type &container) { container.clear(); });
+        }
+
+        /**
+         *  Enqueues resizing the container and returns immediately.
+         *
+         *  @param count The new size of the container.
+         */
+        void resize(size_type count) {
+            batch_update([count](container_type &container) { container.resize(count); });
+        }
+
+        /**
+         *  Blocks until every operation enqueued before this call has been published.
+         *  After flush() returns, lock() observes all of the calling thread's writes.
+         */
+        void flush() {
+            std::unique_lock<std::mutex> lock(_queue_mutex);
+            _drained.wait(lock, [this] { return _pending == 0; });
+        }
+
+        /**
+         *  Returns the number of operations enqueued but not yet published.
+         */
+        size_type pending() const {
+            std::lock_guard<std::mutex> lock(_queue_mutex);
+            return _pending;
+        }
+
+        /**
+         *  Gets the snapshot of the last published version.
+         */
+        snapshot lock() const noexcept {
+            return _vector.lock();
+        }
+
+        /**
+         *  Gets a pinned read view of the last published version (see
+         *  copy_on_write_vector::pin).
+         */
+        pinned_snapshot pin() const {
+            return _vector.pin();
+        }
+
+        /**
+         *  Gets the n-th element of the last published version with bounds checking.
+         */
+        const_reference at(size_type n) const {
+            return _vector.at(n);
+        }
+
+        /**
+         *  Checks whether the last published version is empty.
+         */
+        bool empty() const noexcept {
+            return _vector.empty();
+        }
+
+        /**
+         *  Returns the number of elements of the last published version.
+         */
+        size_type size() const noexcept {
+            return _vector.size();
+        }
+
+    private:
+        /**
+         *  The publisher loop. Waits for operations, drains the whole queue in one go and
+         *  applies the drained batch through a single batch_update of the underlying
+         *  container, then publishes by letting that batch_update republish the version.
+         *  Returns once stopped and the queue is empty, so destruction never drops writes.
+         */
+        void run() {
+            std::unique_lock<std::mutex> lock(_queue_mutex);
+            for (;;) {
+                _ready.wait(lock, [this] { return _stopped || !_queue.empty(); });
+                if (_queue.empty()) {
+                    if (_stopped) {
+                        return;
+                    }
+                    continue;
+                }
+                auto batch = std::move(_queue);
+                _queue.clear();
+                lock.unlock();
+                _vector.batch_update([&batch](container_type &container) {
+                    for (auto &operation : batch) {
+                        operation(container);
+                    }
+                });
+                lock.lock();
+                _pending -= batch.size();
+                if (_pending == 0) {
+                    _drained.notify_all();
+                }
+            }
+        }
+
+        vector_type _vector;
+        std::vector<std::function<void(container_type &)>> _queue;
+        size_type _pending;
+        bool _stopped;
+        std::thread _publisher;
+        std::condition_variable _ready;
+        std::condition_variable _drained;
+        mutable std::mutex _queue_mutex;
+    };
+}
+
+#endif /* defined(__ferrum__async_copy_on_write_vector__) */
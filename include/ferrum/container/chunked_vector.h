@@ -0,0 +1,916 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Daisuke Itabashi (https://github.com/idaisuke/ferrum)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef __ferrum__chunked_vector__
+#define __ferrum__chunked_vector__
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "copy_on_write_vector.h"
+
+namespace fe {
+
+    /**
+     *  Represents a sequence container backed by fixed-size chunks that are shared
+     *  structurally between copies.
+     *  Copying the container copies only the spine of chunk pointers, and a chunk is
+     *  cloned lazily when it is mutated while still shared with another copy.
+     *  This makes a copy-then-single-element-update O(n / ChunkSize + ChunkSize)
+     *  memory traffic instead of O(n), while iteration stays contiguous within chunks.
+     *
+     *  This container is intended as the backing store of fe::copy_on_write_vector for
+     *  large element counts, selectable through its Container template parameter.
+     *
+     *  ~~~~~~~~~~
+     *  fe::chunked_copy_on_write_vector<int> vec;
+     *
+     *  // a push_back copies one chunk plus the spine instead of all elements.
+     *  vec.push_back(999);
+     *  ~~~~~~~~~~
+     *
+     *  @tparam T         The type of the elements.
+     *  @tparam ChunkSize The number of elements stored in one chunk.
+     *  @tparam Allocator An allocator that is used to acquire memory to store the elements.
+     */
+    template <class T, std::size_t ChunkSize = 1024, class Allocator = std::allocator<T>>
+    class chunked_vector {
+    public:
+        /**
+         *  The type of the elements.
+         */
+        using value_type = T;
+
+        /**
+         *  The type of the allocator.
+         */
+        using allocator_type = Allocator;
+
+        /**
+         *  The type of one chunk.
+         */
+        using chunk_type = std::vector<value_type, allocator_type>;
+
+        /**
+         *  The unsigned integral type of the size of the container.
+         */
+        using size_type = typename chunk_type::size_type;
+
+        /**
+         *  The signed integral type of difference of two iterators.
+         */
+        using difference_type = typename chunk_type::difference_type;
+
+        /**
+         *  The reference type of the elements.
+         */
+        using reference = typename chunk_type::reference;
+
+        /**
+         *  The const reference type of the elements.
+         */
+        using const_reference = typename chunk_type::const_reference;
+
+        /**
+         *  The pointer type of the elements.
+         */
+        using pointer = typename chunk_type::pointer;
+
+        /**
+         *  The const pointer type of the elements.
+         */
+        using const_pointer = typename chunk_type::const_pointer;
+
+        class const_iterator;
+
+        /**
+         *  Represents a random access iterator.
+         *  Dereferencing through this iterator unshares the touched chunk.
+         */
+        class iterator
+            : public std::iterator<std::random_access_iterator_tag, value_type, difference_type, pointer, reference> {
+        public:
+            iterator() noexcept : _container(nullptr), _index(0) {
+            }
+
+            reference operator*() const {
+                return (*_container)[static_cast<size_type>(_index)];
+            }
+
+            pointer operator->() const {
+                return &(*_container)[static_cast<size_type>(_index)];
+            }
+
+            reference operator[](difference_type n) const {
+                return (*_container)[static_cast<size_type>(_index + n)];
+            }
+
+            iterator &operator++() {
+                ++_index;
+                return *this;
+            }
+
+            iterator operator++(int) {
+                auto itr = *this;
+                ++_index;
+                return itr;
+            }
+
+            iterator &operator--() {
+                --_index;
+                return *this;
+            }
+
+            iterator operator--(int) {
+                auto itr = *this;
+                --_index;
+                return itr;
+            }
+
+            iterator &operator+=(difference_type distance) {
+                _index += distance;
+                return *this;
+            }
+
+            iterator &operator-=(difference_type distance) {
+                _index -= distance;
+                return *this;
+            }
+
+            friend iterator operator+(iterator lhs, difference_type rhs) {
+                lhs._index += rhs;
+                return lhs;
+            }
+
+            friend iterator operator+(difference_type lhs, iterator rhs) {
+                rhs._index += lhs;
+                return rhs;
+            }
+
+            friend iterator operator-(iterator lhs, difference_type rhs) {
+                lhs._index -= rhs;
+                return lhs;
+            }
+
+            friend difference_type operator-(const iterator &lhs, const iterator &rhs) {
+                return lhs._index - rhs._index;
+            }
+
+            friend bool operator==(const iterator &lhs, const iterator &rhs) {
+                return lhs._index == rhs._index;
+            }
+
+            friend bool operator!=(const iterator &lhs, const iterator &rhs) {
+                return lhs._index != rhs._index;
+            }
+
+            friend bool operator<(const iterator &lhs, const iterator &rhs) {
+                return lhs._index < rhs._index;
+            }
+
+            friend bool operator<=(const iterator &lhs, const iterator &rhs) {
+                return lhs._index <= rhs._index;
+            }
+
+            friend bool operator>(const iterator &lhs, const iterator &rhs) {
+                return lhs._index > rhs._index;
+            }
+
+            friend bool operator>=(const iterator &lhs, const iterator &rhs) {
+                return lhs._index >= rhs._index;
+            }
+
+        private:
+            iterator(chunked_vector *container, difference_type index) noexcept
+                : _container(container), _index(index) {
+            }
+
+            chunked_vector *_container;
+            difference_type _index;
+
+            friend class chunked_vector;
+            friend class const_iterator;
+        };
+
+        /**
+         *  Represents a constant random access iterator.
+         */
+        class const_iterator
+            : public std::iterator<std::random_access_iterator_tag, value_type, difference_type, const_pointer,
+                                   const_reference> {
+        public:
+            const_iterator() noexcept : _container(nullptr), _index(0) {
+            }
+
+            const_iterator(const iterator &other) noexcept : _container(other._container), _index(other._index) {
+            }
+
+            const_reference operator*() const {
+                return _container->element(static_cast<size_type>(_index));
+            }
+
+            const_pointer operator->() const {
+                return &_container->element(static_cast<size_type>(_index));
+            }
+
+            const_reference operator[](difference_type n) const {
+                return _container->element(static_cast<size_type>(_index + n));
+            }
+
+            const_iterator &operator++() {
+                ++_index;
+                return *this;
+            }
+
+            const_iterator operator++(int) {
+                auto itr = *this;
+                ++_index;
+                return itr;
+            }
+
+            const_iterator &operator--() {
+                --_index;
+                return *this;
+            }
+
+            const_iterator operator--(int) {
+                auto itr = *this;
+                --_index;
+                return itr;
+            }
+
+            const_iterator &operator+=(difference_type distance) {
+                _index += distance;
+                return *this;
+            }
+
+            const_iterator &operator-=(difference_type distance) {
+                _index -= distance;
+                return *this;
+            }
+
+            friend const_iterator operator+(const_iterator lhs, difference_type rhs) {
+                lhs._index += rhs;
+                return lhs;
+            }
+
+            friend const_iterator operator+(difference_type lhs, const_iterator rhs) {
+                rhs._index += lhs;
+                return rhs;
+            }
+
+            friend const_iterator operator-(const_iterator lhs, difference_type rhs) {
+                lhs._index -= rhs;
+                return lhs;
+            }
+
+            friend difference_type operator-(const const_iterator &lhs, const const_iterator &rhs) {
+                return lhs._index - rhs._index;
+            }
+
+            friend bool operator==(const const_iterator &lhs, const const_iterator &rhs) {
+                return lhs._index == rhs._index;
+            }
+
+            friend bool operator!=(const const_iterator &lhs, const const_iterator &rhs) {
+                return lhs._index != rhs._index;
+            }
+
+            friend bool operator<(const const_iterator &lhs, const const_iterator &rhs) {
+                return lhs._index < rhs._index;
+            }
+
+            friend bool operator<=(const const_iterator &lhs, const const_iterator &rhs) {
+                return lhs._index <= rhs._index;
+            }
+
+            friend bool operator>(const const_iterator &lhs, const const_iterator &rhs) {
+                return lhs._index > rhs._index;
+            }
+
+            friend bool operator>=(const const_iterator &lhs, const const_iterator &rhs) {
+                return lhs._index >= rhs._index;
+            }
+
+        private:
+            const_iterator(const chunked_vector *container, difference_type index) noexcept
+                : _container(container), _index(index) {
+            }
+
+            const chunked_vector *_container;
+            difference_type _index;
+
+            friend class chunked_vector;
+        };
+
+        /**
+         *  The type of the constant reverse random access iterator.
+         */
+        using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+        /**
+         *  The type of the reverse random access iterator.
+         */
+        using reverse_iterator = std::reverse_iterator<iterator>;
+
+        /**
+         *  Default constructor. Constructs an empty container.
+         */
+        chunked_vector() : chunked_vector(allocator_type()) {
+        }
+
+        /**
+         *  Constructs an empty container.
+         *
+         *  @param allocator The user supplied allocator.
+         */
+        explicit chunked_vector(const allocator_type &allocator) : _allocator(allocator), _size(0) {
+        }
+
+        /**
+         *  Constructs the container with the copies of elements with the given value.
+         *
+         *  @param count     The number of elements.
+         *  @param value     The value to initialize elements with.
+         *  @param allocator The user supplied allocator.
+         */
+        chunked_vector(size_type count, const_reference value, const allocator_type &allocator = allocator_type())
+            : _allocator(allocator), _size(0) {
+            resize(count, value);
+        }
+
+        /**
+         *  Constructs the container with the default-inserted instances of value_type.
+         *
+         *  @param count The number of elements.
+         */
+        explicit chunked_vector(size_type count) : _allocator(), _size(0) {
+            resize(count);
+        }
+
+        /**
+         *  Constructs the container with the default-inserted instances of value_type.
+         *
+         *  @param count     The number of elements.
+         *  @param allocator The user supplied allocator.
+         */
+        chunked_vector(size_type count, const allocator_type &allocator) : _allocator(allocator), _size(0) {
+            resize(count);
+        }
+
+        /**
+         *  Constructs the container with the contents of the range [first, last).
+         *
+         *  @param first     The iterator that appoints the top of the range.
+         *  @param last      The iterator that appoints the last next of the range.
+         *  @param allocator The user supplied allocator.
+         */
+        template <class InputIterator,
+                  class = typename std::enable_if<!std::is_integral<InputIterator>::value>::type>
+        chunked_vector(InputIterator first, InputIterator last, const allocator_type &allocator = allocator_type())
+            : _allocator(allocator), _size(0) {
+            while (first != last) {
+                push_back(*first);
+                ++first;
+            }
+        }
+
+        /**
+         *  Copy constructor. Shares all chunks structurally with the other container.
+         *
+         *  @param other Another container.
+         */
+        chunked_vector(const chunked_vector &other) = default;
+
+        /**
+         *  Copy constructor.
+         *
+         *  @param other     Another container.
+         *  @param allocator The user supplied allocator.
+         */
+        chunked_vector(const chunked_vector &other, const allocator_type &allocator)
+            : _allocator(allocator), _chunks(other._chunks), _size(other._size) {
+        }
+
+        /**
+         *  Move constructor.
+         *
+         *  @param other Another container.
+         */
+        chunked_vector(chunked_vector &&other) = default;
+
+        /**
+         *  Move constructor.
+         *
+         *  @param other     Another container.
+         *  @param allocator The user supplied allocator.
+         */
+        chunked_vector(chunked_vector &&other, const allocator_type &allocator)
+            : _allocator(allocator), _chunks(std::move(other._chunks)), _size(other._size) {
+            other._size = 0;
+        }
+
+        /**
+         *  Constructs the container with the contents of the initializer list.
+         *
+         *  @param initializer_list The initializer list to initialize the elements of the container with.
+         *  @param allocator        The user supplied allocator.
+         */
+        chunked_vector(std::initializer_list<value_type> initializer_list,
+                       const allocator_type &allocator = allocator_type())
+            : chunked_vector(initializer_list.begin(), initializer_list.end(), allocator) {
+        }
+
+        /**
+         *  Copy assignment operator. Shares all chunks structurally with the other container.
+         */
+        chunked_vector &operator=(const chunked_vector &other) = default;
+
+        /**
+         *  Move assignment operator.
+         */
+        chunked_vector &operator=(chunked_vector &&other) = default;
+
+        /**
+         *  Replaces the contents with the copies of the given value.
+         *
+         *  @param count The number of elements.
+         *  @param value The value to initialize elements with.
+         */
+        void assign(size_type count, const_reference value) {
+            clear();
+            resize(count, value);
+        }
+
+        /**
+         *  Replaces the contents with copies of those in the range [first, last).
+         *
+         *  @param first The iterator that appoints the top of the range.
+         *  @param last  The iterator that appoints the last next of the range.
+         */
+        template <class InputIterator,
+                  class = typename std::enable_if<!std::is_integral<InputIterator>::value>::type>
+        void assign(InputIterator first, InputIterator last) {
+            clear();
+            while (first != last) {
+                push_back(*first);
+                ++first;
+            }
+        }
+
+        /**
+         *  Replaces the contents with the elements from the initializer list.
+         *
+         *  @param initializer_list The initializer list to copy the values from.
+         */
+        void assign(std::initializer_list<value_type> initializer_list) {
+            assign(initializer_list.begin(), initializer_list.end());
+        }
+
+        /**
+         *  Returns the associated allocator.
+         */
+        allocator_type get_allocator() const {
+            return _allocator;
+        }
+
+        /**
+         *  Gets the n-th element with bounds checking.
+         */
+        const_reference at(size_type n) const {
+            return _chunks.at(n / ChunkSize)->at(n % ChunkSize);
+        }
+
+        /**
+         *  Gets the n-th element. This operation unshares the touched chunk.
+         */
+        reference operator[](size_type n) {
+            ensure_unique(n / ChunkSize);
+            return (*_chunks[n / ChunkSize])[n % ChunkSize];
+        }
+
+        /**
+         *  Gets the n-th element.
+         */
+        const_reference operator[](size_type n) const {
+            return element(n);
+        }
+
+        /**
+         *  Gets the first element.
+         */
+        const_reference front() const {
+            return element(0);
+        }
+
+        /**
+         *  Gets the last element.
+         */
+        const_reference back() const {
+            return element(_size - 1);
+        }
+
+        /**
+         *  Returns the iterator to the beginning.
+         */
+        iterator begin() noexcept {
+            return iterator(this, 0);
+        }
+
+        /**
+         *  Returns the iterator to the end.
+         */
+        iterator end() noexcept {
+            return iterator(this, static_cast<difference_type>(_size));
+        }
+
+        /**
+         *  Returns the constant iterator to the beginning.
+         */
+        const_iterator begin() const noexcept {
+            return const_iterator(this, 0);
+        }
+
+        /**
+         *  Returns the constant iterator to the end.
+         */
+        const_iterator end() const noexcept {
+            return const_iterator(this, static_cast<difference_type>(_size));
+        }
+
+        /**
+         *  Returns the constant iterator to the beginning.
+         */
+        const_iterator cbegin() const noexcept {
+            return begin();
+        }
+
+        /**
+         *  Returns the constant iterator to the end.
+         */
+        const_iterator cend() const noexcept {
+            return end();
+        }
+
+        /**
+         *  Checks whether the container is empty.
+         */
+        bool empty() const noexcept {
+            return _size == 0;
+        }
+
+        /**
+         *  Returns the number of elements.
+         */
+        size_type size() const noexcept {
+            return _size;
+        }
+
+        /**
+         *  Returns the max possible number of elements.
+         */
+        size_type max_size() const noexcept {
+            return std::allocator_traits<allocator_type>::max_size(_allocator);
+        }
+
+        /**
+         *  Reserves storage for the spine of chunk pointers.
+         *
+         *  @param new_cap The new capacity of the container.
+         */
+        void reserve(size_type new_cap) {
+            _chunks.reserve((new_cap + ChunkSize - 1) / ChunkSize);
+        }
+
+        /**
+         *  Returns the number of elements that the allocated chunks can hold.
+         */
+        size_type capacity() const {
+            return _chunks.size() * ChunkSize;
+        }
+
+        /**
+         *  Requests the removal of unused capacity of the spine.
+         */
+        void shrink_to_fit() {
+            _chunks.shrink_to_fit();
+        }
+
+        /**
+         *  Clears the contents. The chunks shared with other copies are unaffected.
+         */
+        void clear() noexcept {
+            _chunks.clear();
+            _size = 0;
+        }
+
+        /**
+         *  Inserts value before the given position.
+         *
+         *  @param pos   The iterator that appoints the position to insert.
+         *  @param value The value to insert.
+         */
+        iterator insert(iterator pos, const_reference value) {
+            auto index = pos - begin();
+            push_back(value);
+            std::rotate(begin() + index, end() - 1, end());
+            return begin() + index;
+        }
+
+        /**
+         *  Inserts value before the given position.
+         *
+         *  @param pos   The iterator that appoints the position to insert.
+         *  @param value The value to insert.
+         */
+        iterator insert(iterator pos, value_type &&value) {
+            auto index = pos - begin();
+            push_back(std::move(value));
+            std::rotate(begin() + index, end() - 1, end());
+            return begin() + index;
+        }
+
+        /**
+         *  Inserts the copies of the value before the given position.
+         *
+         *  @param pos   The iterator that appoints the position to insert.
+         *  @param count The number of elements to insert.
+         *  @param value The value to insert.
+         */
+        iterator insert(iterator pos, size_type count, const_reference value) {
+            auto index = pos - begin();
+            for (size_type i = 0; i < count; ++i) {
+                push_back(value);
+            }
+            std::rotate(begin() + index, end() - static_cast<difference_type>(count), end());
+            return begin() + index;
+        }
+
+        /**
+         *  Inserts elements from range [first, last) before the given position.
+         *
+         *  @param pos   The iterator that appoints the position to insert.
+         *  @param first The iterator that appoints the top of the range.
+         *  @param last  The iterator that appoints the last next of the range.
+         */
+        template <class InputIterator,
+                  class = typename std::enable_if<!std::is_integral<InputIterator>::value>::type>
+        iterator insert(iterator pos, InputIterator first, InputIterator last) {
+            auto index = pos - begin();
+            auto old_size = _size;
+            while (first != last) {
+                push_back(*first);
+                ++first;
+            }
+            std::rotate(begin() + index, begin() + static_cast<difference_type>(old_size), end());
+            return begin() + index;
+        }
+
+        /**
+         *  Inserts elements from initializer list before the given position.
+         *
+         *  @param pos              The iterator that appoints the position to insert.
+         *  @param initializer_list The initializer list to insert.
+         */
+        iterator insert(iterator pos, std::initializer_list<value_type> initializer_list) {
+            return insert(pos, initializer_list.begin(), initializer_list.end());
+        }
+
+        /**
+         *  Inserts a new element into the container directly before the given position.
+         *
+         *  @param pos  The iterator that appoints the position to emplace.
+         *  @param args The arguments to forward to the constructor of the element.
+         */
+        template <class... ArgTypes>
+        iterator emplace(iterator pos, ArgTypes &&... args) {
+            auto index = pos - begin();
+            emplace_back(std::forward<ArgTypes>(args)...);
+            std::rotate(begin() + index, end() - 1, end());
+            return begin() + index;
+        }
+
+        /**
+         *  Erases the element at the given position.
+         *
+         *  @param pos The iterator that appoints the position to erase.
+         */
+        iterator erase(iterator pos) {
+            std::move(pos + 1, end(), pos);
+            pop_back();
+            return pos;
+        }
+
+        /**
+         *  Erases the elements in the range [first, last).
+         *
+         *  @param first The iterator that appoints the top of the range.
+         *  @param last  The iterator that appoints the last next of the range.
+         */
+        iterator erase(iterator first, iterator last) {
+            auto count = last - first;
+            std::move(last, end(), first);
+            for (difference_type i = 0; i < count; ++i) {
+                pop_back();
+            }
+            return first;
+        }
+
+        /**
+         *  Adds the element to the end. Only the last chunk is unshared.
+         *
+         *  @param value The new element is initialized as a copy of this value.
+         */
+        void push_back(const_reference value) {
+            writable_back_chunk()->push_back(value);
+            ++_size;
+        }
+
+        /**
+         *  Adds the element to the end. Only the last chunk is unshared.
+         *
+         *  @param value The value to be moved into the new element.
+         */
+        void push_back(value_type &&value) {
+            writable_back_chunk()->push_back(std::move(value));
+            ++_size;
+        }
+
+        /**
+         *  Adds a new element into the container directly to the end.
+         *
+         *  @param args The arguments to forward to the constructor of the element.
+         */
+        template <class... ArgTypes>
+        void emplace_back(ArgTypes &&... args) {
+            writable_back_chunk()->emplace_back(std::forward<ArgTypes>(args)...);
+            ++_size;
+        }
+
+        /**
+         *  Removes the last element. Only the last chunk is unshared.
+         */
+        void pop_back() {
+            ensure_unique(_chunks.size() - 1);
+            _chunks.back()->pop_back();
+            if (_chunks.back()->empty()) {
+                _chunks.pop_back();
+            }
+            --_size;
+        }
+
+        /**
+         *  Resizes the container.
+         *  If the current size is less than the given count, the default-inserted instances of value_type are appended.
+         *
+         *  @param count The new size of the container.
+         */
+        void resize(size_type count) {
+            while (_size > count) {
+                pop_back();
+            }
+            while (_size < count) {
+                emplace_back();
+            }
+        }
+
+        /**
+         *  Resizes the container.
+         *  If the current size is less than the given count, the copies of the given value are appended.
+         *
+         *  @param count The new size of the container.
+         *  @param value The value to initialize the new elements with.
+         */
+        void resize(size_type count, const_reference value) {
+            while (_size > count) {
+                pop_back();
+            }
+            while (_size < count) {
+                push_back(value);
+            }
+        }
+
+        /**
+         *  Swaps the contents.
+         *
+         *  @param other The container to exchange the contents with.
+         */
+        void swap(chunked_vector &other) {
+            _chunks.swap(other._chunks);
+            std::swap(_size, other._size);
+            std::swap(_allocator, other._allocator);
+        }
+
+        /**
+         *  Compares the contents of two containers.
+         */
+        friend bool operator==(const chunked_vector &lhs, const chunked_vector &rhs) {
+            return lhs._size == rhs._size && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+        }
+
+        /**
+         *  Compares the contents of two containers.
+         */
+        friend bool operator!=(const chunked_vector &lhs, const chunked_vector &rhs) {
+            return !(lhs == rhs);
+        }
+
+        /**
+         *  Compares the contents of two containers.
+         */
+        friend bool operator<(const chunked_vector &lhs, const chunked_vector &rhs) {
+            return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+        }
+
+        /**
+         *  Compares the contents of two containers.
+         */
+        friend bool operator<=(const chunked_vector &lhs, const chunked_vector &rhs) {
+            return !(rhs < lhs);
+        }
+
+        /**
+         *  Compares the contents of two containers.
+         */
+        friend bool operator>(const chunked_vector &lhs, const chunked_vector &rhs) {
+            return rhs < lhs;
+        }
+
+        /**
+         *  Compares the contents of two containers.
+         */
+        friend bool operator>=(const chunked_vector &lhs, const chunked_vector &rhs) {
+            return !(lhs < rhs);
+        }
+
+    private:
+        const_reference element(size_type n) const {
+            return (*_chunks[n / ChunkSize])[n % ChunkSize];
+        }
+
+        void ensure_unique(size_type chunk_index) {
+            auto &chunk = _chunks[chunk_index];
+            if (chunk.use_count() > 1) {
+                auto copied_chunk = std::make_shared<chunk_type>(*chunk);
+                copied_chunk->reserve(ChunkSize);
+                chunk = std::move(copied_chunk);
+            }
+        }
+
+        std::shared_ptr<chunk_type> &writable_back_chunk() {
+            if (_size % ChunkSize == 0) {
+                auto chunk = std::make_shared<chunk_type>(_allocator);
+                chunk->reserve(ChunkSize);
+                _chunks.push_back(std::move(chunk));
+            } else {
+                ensure_unique(_chunks.size() - 1);
+            }
+            return _chunks.back();
+        }
+
+        allocator_type _allocator;
+        std::vector<std::shared_ptr<chunk_type>> _chunks;
+        size_type _size;
+
+        friend class iterator;
+        friend class const_iterator;
+    };
+
+    /**
+     *  The alias of copy_on_write_vector whose underlying container is fe::chunked_vector,
+     *  so that mutations copy only the touched chunks plus the spine instead of all elements.
+     *
+     *  @tparam T         The type of the elements.
+     *  @tparam ChunkSize The number of elements stored in one chunk.
+     *  @tparam Allocator An allocator that is used to acquire memory to store the elements.
+     */
+    template <class T, std::size_t ChunkSize = 1024, class Allocator = std::allocator<T>>
+    using chunked_copy_on_write_vector = copy_on_write_vector<T, Allocator, chunked_vector<T, ChunkSize, Allocator>>;
+}
+
+#endif /* defined(__ferrum__chunked_vector__) */
@@ -0,0 +1,747 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Daisuke Itabashi (https://github.com/idaisuke/ferrum)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef __ferrum__copy_on_write_map__
+#define __ferrum__copy_on_write_map__
+
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace fe {
+
+    /**
+     *  Represents a thread-safe associative container for C++11, sharing the snapshot
+     *  design of fe::copy_on_write_vector.
+     *  All iterators are unaffected by all operations in this class,
+     *  because all mutative operations(such as insert) make a fresh copy of the underlying container.
+     *  Lookups on a snapshot run against the underlying keyed container, so they cost
+     *  O(log n) or O(1) instead of the linear scan a vector of pairs would need.
+     *
+     *  ~~~~~~~~~~
+     *  fe::copy_on_write_map<std::string, int> map = {{"two", 2}, {"three", 3}};
+     *
+     *  // get a read-only snapshot.
+     *  auto snapshot = map.lock();
+     *
+     *  int value = snapshot.at("two");
+     *
+     *  // any mutative operations are possible while the snapshot is alive.
+     *  map.insert(std::make_pair("five", 5));
+     *  ~~~~~~~~~~
+     *
+     *  @tparam Container The type of the underlying keyed container that holds one version
+     *                    of the elements, e.g. std::map or std::unordered_map.
+     */
+    template <class Container>
+    class basic_copy_on_write_map {
+    public:
+        /**
+         *  The type of the underlying container.
+         */
+        using container_type = Container;
+
+        /**
+         *  The type of the keys.
+         */
+        using key_type = typename container_type::key_type;
+
+        /**
+         *  The type of the mapped values.
+         */
+        using mapped_type = typename container_type::mapped_type;
+
+        /**
+         *  The type of the elements.
+         */
+        using value_type = typename container_type::value_type;
+
+        /**
+         *  The type of the allocator.
+         */
+        using allocator_type = typename container_type::allocator_type;
+
+        /**
+         *  The unsigned integral type of the size of the underlying container.
+         */
+        using size_type = typename container_type::size_type;
+
+        /**
+         *  The signed integral type of difference of two iterators.
+         */
+        using difference_type = typename container_type::difference_type;
+
+        /**
+         *  The reference type of the elements.
+         */
+        using reference = typename container_type::reference;
+
+        /**
+         *  The const reference type of the elements.
+         */
+        using const_reference = typename container_type::const_reference;
+
+        class snapshot;
+
+        /**
+         *  Represents a constant iterator with the category of the underlying container.
+         */
+        class const_forward_iterator
+            : public std::iterator<typename std::iterator_traits<typename container_type::const_iterator>::iterator_category,
+                                   value_type, difference_type, const value_type *, const_reference> {
+        public:
+            const_reference operator*() const {
+                return *_itr;
+            }
+
+            const value_type *operator->() const {
+                return std::addressof(*_itr);
+            }
+
+            const_forward_iterator &operator++() {
+                ++_itr;
+                return *this;
+            }
+
+            const_forward_iterator operator++(int) {
+                auto itr = _itr;
+                ++(*this);
+                return const_forward_iterator(_shared_container, std::move(itr));
+            }
+
+            friend bool operator==(const const_forward_iterator &lhs, const const_forward_iterator &rhs) {
+                return lhs._itr == rhs._itr;
+            }
+
+            friend bool operator!=(const const_forward_iterator &lhs, const const_forward_iterator &rhs) {
+                return lhs._itr != rhs._itr;
+            }
+
+        private:
+            const_forward_iterator(std::shared_ptr<container_type> shared_container,
+                                   typename container_type::const_iterator &&itr) noexcept
+                : _shared_container(std::move(shared_container)),
+                  _itr(std::move(itr)) {
+            }
+
+            static const_forward_iterator begin(std::shared_ptr<container_type> shared_container) noexcept {
+                return const_forward_iterator(shared_container, shared_container->cbegin());
+            }
+
+            static const_forward_iterator end(std::shared_ptr<container_type> shared_container) noexcept {
+                return const_forward_iterator(shared_container, shared_container->cend());
+            }
+
+            std::shared_ptr<container_type> _shared_container;
+            typename container_type::const_iterator _itr;
+
+            friend class snapshot;
+        };
+
+        /**
+         *  The type of the constant iterator.
+         */
+        using iterator = const_forward_iterator;
+
+        /**
+         *  The alias of iterator.
+         */
+        using const_iterator = iterator;
+
+        /**
+         *  Represents a snapshot of this container from a certain time.
+         */
+        class snapshot {
+        public:
+            /**
+             *  Returns the associated allocator
+             */
+            allocator_type get_allocator() const {
+                return _shared_container->get_allocator();
+            }
+
+            /**
+             *  Returns the iterator to the beginning.
+             */
+            iterator begin() const noexcept {
+                return iterator::begin(_shared_container);
+            }
+
+            /**
+             *  Returns the iterator to the end.
+             */
+            iterator end() const noexcept {
+                return iterator::end(_shared_container);
+            }
+
+            /**
+             *  Returns the iterator to the beginning.
+             */
+            iterator cbegin() const noexcept {
+                return iterator::begin(_shared_container);
+            }
+
+            /**
+             *  Returns the iterator to the end.
+             */
+            iterator cend() const noexcept {
+                return iterator::end(_shared_container);
+            }
+
+            /**
+             *  Gets the mapped value of the given key with bounds checking.
+             */
+            const mapped_type &at(const key_type &key) const {
+                return _shared_container->at(key);
+            }
+
+            /**
+             *  Returns the number of elements with the given key.
+             */
+            size_type count(const key_type &key) const {
+                return _shared_container->count(key);
+            }
+
+            /**
+             *  Finds the element with the given key.
+             */
+            iterator find(const key_type &key) const {
+                return iterator(_shared_container, _shared_container->find(key));
+            }
+
+            /**
+             *  Checks whether the container is empty.
+             */
+            bool empty() const noexcept {
+                return _shared_container->empty();
+            }
+
+            /**
+             *  Returns the number of elements.
+             */
+            size_type size() const noexcept {
+                return _shared_container->size();
+            }
+
+            /**
+             *  Returns the max possible number of elements.
+             */
+            size_type max_size() const noexcept {
+                return _shared_container->max_size();
+            }
+
+        private:
+            snapshot(std::shared_ptr<container_type> shared_container) noexcept
+                : _shared_container(std::move(shared_container)) {
+            }
+
+            std::shared_ptr<container_type> _shared_container;
+
+            friend class basic_copy_on_write_map;
+        };
+
+        /**
+         *  Default constructor. Constructs an empty container.
+         */
+        basic_copy_on_write_map() : _shared_container(std::make_shared<container_type>()) {
+        }
+
+        /**
+         *  Constructs an empty container.
+         *
+         *  @param allocator The user supplied allocator.
+         */
+        explicit basic_copy_on_write_map(const allocator_type &allocator)
+            : _shared_container(std::make_shared<container_type>(allocator)) {
+        }
+
+        /**
+         *  Constructs the container with the contents of the range [first, last).
+         *
+         *  @param first, last The range to copy the elements from.
+         */
+        template <class InputIterator>
+        basic_copy_on_write_map(InputIterator first, InputIterator last)
+            : _shared_container(std::make_shared<container_type>(first, last)) {
+        }
+
+        /**
+         *  Constructs the container with the contents of the initializer list.
+         *
+         *  @param initializer_list The initializer list to copy the elements from.
+         */
+        basic_copy_on_write_map(std::initializer_list<value_type> initializer_list)
+            : _shared_container(std::make_shared<container_type>(initializer_list)) {
+        }
+
+        /**
+         *  Constructs the container with the copy of the given container.
+         *
+         *  @param container The container to copy the elements from.
+         */
+        basic_copy_on_write_map(const container_type &container)
+            : _shared_container(std::make_shared<container_type>(container)) {
+        }
+
+        /**
+         *  Constructs the container with the contents of the given container using move semantics.
+         *
+         *  @param container The container to move the elements from.
+         */
+        basic_copy_on_write_map(container_type &&container)
+            : _shared_container(std::make_shared<container_type>(std::move(container))) {
+        }
+
+        /**
+         *  Copy constructor.
+         *
+         *  @param other Another container to copy the elements from.
+         */
+        basic_copy_on_write_map(const basic_copy_on_write_map &other)
+            : _shared_container(std::make_shared<container_type>(*other.lock()._shared_container)) {
+        }
+
+        /**
+         *  Move constructor.
+         *
+         *  @param other Another container to move the elements from.
+         */
+        basic_copy_on_write_map(basic_copy_on_write_map &&other)
+            : _shared_container(std::make_shared<container_type>(std::move(*other.lock()._shared_container))) {
+        }
+
+        /**
+         *  Copy assignment operator.
+         *
+         *  @param other Another container to copy the elements from.
+         */
+        basic_copy_on_write_map &operator=(const basic_copy_on_write_map &other) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            std::atomic_store(&_shared_container,
+                              std::make_shared<container_type>(*other.lock()._shared_container));
+            return *this;
+        }
+
+        /**
+         *  Move assignment operator.
+         *
+         *  @param other Another container to move the elements from.
+         */
+        basic_copy_on_write_map &operator=(basic_copy_on_write_map &&other) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            std::atomic_store(&_shared_container,
+                              std::make_shared<container_type>(std::move(*other.lock()._shared_container)));
+            return *this;
+        }
+
+        /**
+         *  Replaces the contents with the contents of the initializer list.
+         *
+         *  @param initializer_list The initializer list to copy the elements from.
+         */
+        basic_copy_on_write_map &operator=(std::initializer_list<value_type> initializer_list) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            std::atomic_store(&_shared_container, std::make_shared<container_type>(initializer_list));
+            return *this;
+        }
+
+        /**
+         *  Returns the associated allocator
+         */
+        allocator_type get_allocator() const {
+            return lock()._shared_container->get_allocator();
+        }
+
+        /**
+         *  Gets the mapped value of the given key with bounds checking.
+         */
+        const mapped_type &at(const key_type &key) const {
+            return lock()._shared_container->at(key);
+        }
+
+        /**
+         *  Returns the number of elements with the given key.
+         */
+        size_type count(const key_type &key) const {
+            return lock()._shared_container->count(key);
+        }
+
+        /**
+         *  Gets the snapshot of the current container.
+         *  This operation is wait-free while any snapshot is outstanding; it retries only
+         *  while a writer is running an exclusive in-place mutation (see exclusive_claim).
+         */
+        snapshot lock() const noexcept {
+            for (;;) {
+                auto shared_container = std::atomic_load(&_shared_container);
+                if (shared_container) {
+                    return snapshot(std::move(shared_container));
+                }
+                std::this_thread::yield();
+            }
+        }
+
+        /**
+         *  Checks whether the container is empty.
+         */
+        bool empty() const noexcept {
+            return lock()._shared_container->empty();
+        }
+
+        /**
+         *  Returns the number of elements.
+         */
+        size_type size() const noexcept {
+            return lock()._shared_container->size();
+        }
+
+        /**
+         *  Returns the max possible number of elements.
+         */
+        size_type max_size() const noexcept {
+            return lock()._shared_container->max_size();
+        }
+
+        /**
+         *  Removes all elements.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
+         */
+        void clear() {
+            mutate([](container_type &container) { container.clear(); });
+        }
+
+        /**
+         *  Inserts the given element if the container does not already contain an element
+         *  with the same key.
+         *  This operation copies the underlying container only when both a snapshot is
+         *  outstanding and the element is inserted.
+         *
+         *  @param value The element to insert.
+         *
+         *  @return ​true if the element was inserted, false otherwise.
+         */
+        bool insert(const value_type &value) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            exclusive_claim claimed(*this);
+            if (claimed) {
+                return claimed->insert(value).second;
+            }
+            auto shared_container = std::atomic_load(&_shared_container);
+            if (shared_container->find(value.first) != shared_container->end()) {
+                return false;
+            }
+            auto copied_container = copy_version(*shared_container);
+            copied_container->insert(value);
+            std::atomic_store(&_shared_container, std::move(copied_container));
+            retire_version(std::move(shared_container));
+            return true;
+        }
+
+        /**
+         *  Inserts the elements of the range [first, last).
+         *  This operation copies the underlying container only when a snapshot is outstanding.
+         *
+         *  @param first, last The range to copy the elements from.
+         */
+        template <class InputIterator>
+        void insert(InputIterator first, InputIterator last) {
+            mutate([&first, &last](container_type &container) { container.insert(first, last); });
+        }
+
+        /**
+         *  Inserts the elements of the initializer list.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
+         *
+         *  @param initializer_list The initializer list to copy the elements from.
+         */
+        void insert(std::initializer_list<value_type> initializer_list) {
+            mutate([&initializer_list](container_type &container) { container.insert(initializer_list); });
+        }
+
+        /**
+         *  Inserts the given mapped value if the container does not already contain an
+         *  element with the given key, and assigns it to the existing element otherwise.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
+         *
+         *  @param key The key of the element.
+         *  @param obj The mapped value to insert or assign.
+         *
+         *  @return ​true if the element was inserted, false if it was assigned.
+         */
+        bool insert_or_assign(const key_type &key, const mapped_type &obj) {
+            bool result;
+            mutate([&key, &obj, &result](container_type &container) {
+                auto inserted = container.insert(value_type(key, obj));
+                if (!inserted.second) {
+                    inserted.first->second = obj;
+                }
+                result = inserted.second;
+            });
+            return result;
+        }
+
+        /**
+         *  Inserts a new element constructed in place from the given arguments if the
+         *  container does not already contain an element with the same key.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
+         *
+         *  @param args The arguments to forward to the constructor of the element.
+         *
+         *  @return ​true if the element was inserted, false otherwise.
+         */
+        template <class... Args>
+        bool emplace(Args &&... args) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            exclusive_claim claimed(*this);
+            if (claimed) {
+                return claimed->emplace(std::forward<Args>(args)...).second;
+            }
+            auto shared_container = std::atomic_load(&_shared_container);
+            auto copied_container = copy_version(*shared_container);
+            if (!copied_container->emplace(std::forward<Args>(args)...).second) {
+                return false;
+            }
+            std::atomic_store(&_shared_container, std::move(copied_container));
+            retire_version(std::move(shared_container));
+            return true;
+        }
+
+        /**
+         *  Removes the element with the given key if one exists.
+         *  This operation copies the underlying container only when both a snapshot is
+         *  outstanding and an element is removed.
+         *
+         *  @param key The key of the element to remove.
+         *
+         *  @return The number of removed elements.
+         */
+        size_type erase(const key_type &key) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            exclusive_claim claimed(*this);
+            if (claimed) {
+                return claimed->erase(key);
+            }
+            auto shared_container = std::atomic_load(&_shared_container);
+            if (shared_container->find(key) == shared_container->end()) {
+                return 0;
+            }
+            auto copied_container = copy_version(*shared_container);
+            auto result = copied_container->erase(key);
+            std::atomic_store(&_shared_container, std::move(copied_container));
+            retire_version(std::move(shared_container));
+            return result;
+        }
+
+        /**
+         *  Applies the given batch of mutations to one working copy of the underlying
+         *  container and publishes the result as a single new snapshot, so that n
+         *  mutations cost one copy instead of n and intermediate states are never
+         *  observable.
+         *
+         *  @param fn A function that mutates the given container.
+         */
+        template <class UnaryFunction>
+        void batch_update(UnaryFunction fn) {
+            mutate([&fn](container_type &container) { fn(container); });
+        }
+
+        /**
+         *  Exchanges the contents with those of the other container.
+         *
+         *  @param other Another container to exchange the contents with.
+         */
+        void swap(basic_copy_on_write_map &other) {
+            std::lock(_mutex, other._mutex);
+            std::lock_guard<std::mutex> lock(_mutex, std::adopt_lock);
+            std::lock_guard<std::mutex> other_lock(other._mutex, std::adopt_lock);
+
+            exclusive_claim claimed(*this);
+            exclusive_claim other_claimed(other);
+
+            if (claimed && other_claimed) {
+                claimed->swap(*other_claimed);
+                return;
+            }
+            if (claimed) {
+                auto other_shared_container = std::atomic_load(&other._shared_container);
+                auto other_copied_container = other.copy_version(*other_shared_container);
+                claimed->swap(*other_copied_container);
+                std::atomic_store(&other._shared_container, std::move(other_copied_container));
+                other.retire_version(std::move(other_shared_container));
+                return;
+            }
+            if (other_claimed) {
+                auto shared_container = std::atomic_load(&_shared_container);
+                auto copied_container = copy_version(*shared_container);
+                copied_container->swap(*other_claimed);
+                std::atomic_store(&_shared_container, std::move(copied_container));
+                retire_version(std::move(shared_container));
+                return;
+            }
+
+            auto shared_container = std::atomic_load(&_shared_container);
+            auto other_shared_container = std::atomic_load(&other._shared_container);
+            auto copied_container = copy_version(*shared_container);
+            auto other_copied_container = other.copy_version(*other_shared_container);
+
+            copied_container->swap(*other_copied_container);
+
+            std::atomic_store(&_shared_container, std::move(copied_container));
+            std::atomic_store(&other._shared_container, std::move(other_copied_container));
+            retire_version(std::move(shared_container));
+            other.retire_version(std::move(other_shared_container));
+        }
+
+        /**
+         *  Compares the contents of two containers.
+         */
+        friend bool operator==(const basic_copy_on_write_map &lhs, const basic_copy_on_write_map &rhs) {
+            return *std::atomic_load(&lhs._shared_container) == *std::atomic_load(&rhs._shared_container);
+        }
+
+        /**
+         *  Compares the contents of two containers.
+         */
+        friend bool operator!=(const basic_copy_on_write_map &lhs, const basic_copy_on_write_map &rhs) {
+            return *std::atomic_load(&lhs._shared_container) != *std::atomic_load(&rhs._shared_container);
+        }
+
+    private:
+        /**
+         *  Claims the current version for exclusive in-place mutation. The version slot is
+         *  atomically detached, so no new snapshot can be taken while the claim is checked;
+         *  if the writer holds the only reference, the version can be mutated in place with
+         *  zero copy. Otherwise the version is restored immediately and the claim is empty.
+         *  A non-empty claim republishes the version when it goes out of scope, including
+         *  on exception.
+         *  Must be constructed with _mutex held.
+         */
+        class exclusive_claim {
+        public:
+            explicit exclusive_claim(basic_copy_on_write_map &owner) noexcept : _owner(owner) {
+                auto claimed = std::atomic_exchange(&owner._shared_container, std::shared_ptr<container_type>());
+                if (claimed.use_count() == 1) {
+                    _container = std::move(claimed);
+                } else {
+                    std::atomic_store(&owner._shared_container, std::move(claimed));
+                }
+            }
+
+            ~exclusive_claim() {
+                if (_container) {
+                    std::atomic_store(&_owner._shared_container, std::move(_container));
+                }
+            }
+
+            exclusive_claim(const exclusive_claim &) = delete;
+            exclusive_claim &operator=(const exclusive_claim &) = delete;
+
+            explicit operator bool() const noexcept {
+                return static_cast<bool>(_container);
+            }
+
+            container_type &operator*() const noexcept {
+                return *_container;
+            }
+
+            container_type *operator->() const noexcept {
+                return _container.get();
+            }
+
+        private:
+            basic_copy_on_write_map &_owner;
+            std::shared_ptr<container_type> _container;
+        };
+
+        /**
+         *  Applies the given mutation to the current version in place when no snapshot is
+         *  outstanding, and to a fresh copy that is published afterwards otherwise, so that
+         *  the copy cost is only paid when a snapshot actually exists.
+         */
+        template <class UnaryFunction>
+        void mutate(UnaryFunction fn) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            exclusive_claim claimed(*this);
+            if (claimed) {
+                fn(*claimed);
+                return;
+            }
+            auto shared_container = std::atomic_load(&_shared_container);
+            auto copied_container = copy_version(*shared_container);
+            fn(*copied_container);
+            std::atomic_store(&_shared_container, std::move(copied_container));
+            retire_version(std::move(shared_container));
+        }
+
+        /**
+         *  Makes a new version holding a copy of the given source, recycling the retired
+         *  spare version when available and allocating through the user allocator via
+         *  allocate_shared otherwise.
+         *  Must be called with _mutex held.
+         */
+        std::shared_ptr<container_type> copy_version(const container_type &source) {
+            if (_spare_container && _spare_container.use_count() == 1) {
+                auto recycled = std::move(_spare_container);
+                *recycled = source;
+                return recycled;
+            }
+            using version_allocator =
+                typename std::allocator_traits<allocator_type>::template rebind_alloc<container_type>;
+            return std::allocate_shared<container_type>(version_allocator(source.get_allocator()), source);
+        }
+
+        /**
+         *  Keeps the displaced version as the spare for the next copy when no snapshot
+         *  still references it.
+         *  Must be called with _mutex held.
+         */
+        void retire_version(std::shared_ptr<container_type> &&retired) {
+            if (retired.use_count() == 1) {
+                _spare_container = std::move(retired);
+            }
+        }
+
+        mutable std::shared_ptr<container_type> _shared_container;
+        std::shared_ptr<container_type> _spare_container;
+        std::mutex _mutex;
+    };
+
+    /**
+     *  The alias of basic_copy_on_write_map using std::map, giving O(log n) keyed reads
+     *  on immutable snapshots.
+     *
+     *  @tparam Key       The type of the keys.
+     *  @tparam T         The type of the mapped values.
+     *  @tparam Compare   A comparison function object that orders the keys.
+     *  @tparam Allocator An allocator that is used to acquire memory to store the elements.
+     */
+    template <class Key, class T, class Compare = std::less<Key>,
+              class Allocator = std::allocator<std::pair<const Key, T>>>
+    using copy_on_write_map = basic_copy_on_write_map<std::map<Key, T, Compare, Allocator>>;
+}
+
+#endif /* defined(__ferrum__copy_on_write_map__) */
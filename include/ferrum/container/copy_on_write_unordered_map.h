@@ -0,0 +1,50 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Daisuke Itabashi (https://github.com/idaisuke/ferrum)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef __ferrum__copy_on_write_unordered_map__
+#define __ferrum__copy_on_write_unordered_map__
+
+#include <functional>
+#include <unordered_map>
+#include <utility>
+
+#include "copy_on_write_map.h"
+
+namespace fe {
+
+    /**
+     *  The alias of basic_copy_on_write_map using std::unordered_map, giving O(1) keyed
+     *  reads on immutable snapshots.
+     *
+     *  @tparam Key       The type of the keys.
+     *  @tparam T         The type of the mapped values.
+     *  @tparam Hash      A function object that hashes the keys.
+     *  @tparam KeyEqual  A function object that compares the keys for equality.
+     *  @tparam Allocator An allocator that is used to acquire memory to store the elements.
+     */
+    template <class Key, class T, class Hash = std::hash<Key>, class KeyEqual = std::equal_to<Key>,
+              class Allocator = std::allocator<std::pair<const Key, T>>>
+    using copy_on_write_unordered_map =
+        basic_copy_on_write_map<std::unordered_map<Key, T, Hash, KeyEqual, Allocator>>;
+}
+
+#endif /* defined(__ferrum__copy_on_write_unordered_map__) */
@@ -24,15 +24,54 @@
 #define __ferrum__copy_on_write_vector__
 
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
 #include <initializer_list>
 #include <iterator>
 #include <memory>
 #include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "../stats.h"
+
 namespace fe {
 
+    /**
+     *  The on-disk layout of a saved snapshot: this fixed header followed by the raw
+     *  bytes of the elements (see copy_on_write_vector::snapshot::save and
+     *  fe::mapped_vector::map). The header is padded to 32 bytes so that the element
+     *  bytes of a mapped file stay suitably aligned for the value type.
+     */
+    struct snapshot_file_header {
+        /**
+         *  The format magic, "ferrumcw".
+         */
+        char magic[8];
+
+        /**
+         *  The size of one element in bytes, checked against the value type on mapping.
+         */
+        std::uint64_t element_size;
+
+        /**
+         *  The number of elements that follow the header.
+         */
+        std::uint64_t element_count;
+
+        /**
+         *  Reserved for future format revisions, written as zero.
+         */
+        std::uint64_t reserved;
+    };
+
     /**
      *  Represents a thread-safe sequence container for C++11.
      *  All iterators are unaffected by all operations in this class,
@@ -54,9 +93,11 @@ namespace fe {
      *
      *  @tparam T         The type of the elements
      *  @tparam Allocator An allocator that is used to acquire memory to store the elements
+     *  @tparam Container The type of the underlying container that holds one version of the
+     *                    elements, e.g. fe::chunked_vector for structural sharing between versions
      */
-    template <class T, class Allocator = std::allocator<T>>
-    class copy_on_write_vector {
+    template <class T, class Allocator = std::allocator<T>, class Container = std::vector<T, Allocator>>
+    class copy_on_write_vector : private container_stats {
     public:
         /**
          *  The type of the elements.
@@ -71,7 +112,7 @@ namespace fe {
         /**
          *  The type of the underlying container.
          */
-        using container_type = std::vector<value_type, allocator_type>;
+        using container_type = Container;
 
         /**
          *  The unsigned integral type of the size of the underlying container.
@@ -104,6 +145,7 @@ namespace fe {
         using const_pointer = typename container_type::const_pointer;
 
         class snapshot;
+        class pinned_snapshot;
 
         /**
          *  Represents a constant random access iterator.
@@ -253,6 +295,123 @@ namespace fe {
          */
         using const_reverse_iterator = reverse_iterator;
 
+        /**
+         *  Represents a borrowed, trivially copyable view of the elements of one version.
+         *  The iterators are raw element pointers, so a scan over the view compiles down
+         *  to a plain pointer loop the vectorizer recognizes, and copying an iterator
+         *  costs nothing, where copying a snapshot iterator bumps a reference count.
+         *  The view does not keep the version alive by itself and must not outlive the
+         *  snapshot or pinned view it was taken from.
+         *  Only available when the underlying container stores its elements contiguously,
+         *  as the default std::vector backing does.
+         */
+        class element_span {
+        public:
+            /**
+             *  The type of the constant iterator, a raw element pointer.
+             */
+            using const_iterator = const value_type *;
+
+            /**
+             *  The type of the constant reverse iterator.
+             */
+            using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+            /**
+             *  Returns the iterator to the beginning.
+             */
+            const_iterator begin() const noexcept {
+                return _first;
+            }
+
+            /**
+             *  Returns the iterator to the end.
+             */
+            const_iterator end() const noexcept {
+                return _last;
+            }
+
+            /**
+             *  Returns the iterator to the beginning.
+             */
+            const_iterator cbegin() const noexcept {
+                return _first;
+            }
+
+            /**
+             *  Returns the iterator to the end.
+             */
+            const_iterator cend() const noexcept {
+                return _last;
+            }
+
+            /**
+             *  Returns the reverse iterator to the beginning.
+             */
+            const_reverse_iterator rbegin() const noexcept {
+                return const_reverse_iterator(_last);
+            }
+
+            /**
+             *  Returns the reverse iterator to the end.
+             */
+            const_reverse_iterator rend() const noexcept {
+                return const_reverse_iterator(_first);
+            }
+
+            /**
+             *  Gets the pointer to the first element.
+             */
+            const value_type *data() const noexcept {
+                return _first;
+            }
+
+            /**
+             *  Gets the n-th element.
+             */
+            const_reference operator[](size_type n) const {
+                return _first[n];
+            }
+
+            /**
+             *  Gets the first element.
+             */
+            const_reference front() const {
+                return *_first;
+            }
+
+            /**
+             *  Gets the last element.
+             */
+            const_reference back() const {
+                return *(_last - 1);
+            }
+
+            /**
+             *  Checks whether the view is empty.
+             */
+            bool empty() const noexcept {
+                return _first == _last;
+            }
+
+            /**
+             *  Returns the number of elements.
+             */
+            size_type size() const noexcept {
+                return static_cast<size_type>(_last - _first);
+            }
+
+        private:
+            element_span(const value_type *first, const value_type *last) noexcept : _first(first), _last(last) {
+            }
+
+            const value_type *_first;
+            const value_type *_last;
+
+            friend class snapshot;
+            friend class pinned_snapshot;
+        };
+
         /**
          *  Represents a snapshot of this container from a certain time.
          */
@@ -325,35 +484,43 @@ namespace fe {
              *  Gets the n-th element with bounds checking.
              */
             const_reference at(size_type n) const {
-                return _shared_container->at(n);
+                return container().at(n);
             }
 
             /**
              *  Gets the n-th element.
              */
             const_reference operator[](size_type n) const {
-                return (*_shared_container)[n];
+                return container()[n];
             }
 
             /**
              *  Gets the first element.
              */
             const_reference front() const {
-                return _shared_container->front();
+                return container().front();
             }
 
             /**
              *  Gets the last element.
              */
             const_reference back() const {
-                return _shared_container->back();
+                return container().back();
             }
 
             /**
              *  Gets the pointer to the underlying array.
              */
             const_pointer data() const noexcept {
-                return _shared_container->data();
+                return container().data();
+            }
+
+            /**
+             *  Gets a borrowed raw pointer view of the elements (see element_span).
+             *  The view must not outlive this snapshot.
+             */
+            element_span span() const noexcept {
+                return element_span(container().data(), container().data() + container().size());
             }
 
             /**
@@ -384,12 +551,169 @@ namespace fe {
                 return _shared_container->capacity();
             }
 
+            /**
+             *  Returns the version of the container this snapshot was taken at (see
+             *  copy_on_write_vector::version); pass version() + 1 to wait_for_version
+             *  to sleep until something newer than this snapshot is published.
+             */
+            std::uint64_t version() const noexcept {
+                return _version;
+            }
+
+            /**
+             *  Saves the elements to the given file as a fixed header followed by their
+             *  raw bytes (see fe::snapshot_file_header), the format fe::mapped_vector::map
+             *  adopts back without parsing. Only available when the elements are trivially
+             *  copyable and stored contiguously.
+             *  Throws std::runtime_error when the file cannot be written.
+             *
+             *  @param path The path of the file to write.
+             */
+            void save(const char *path) const {
+                static_assert(std::is_trivially_copyable<value_type>::value,
+                              "save requires a trivially copyable element type");
+                auto header = snapshot_file_header();
+                std::memcpy(header.magic, "ferrumcw", sizeof(header.magic));
+                header.element_size = sizeof(value_type);
+                header.element_count = _shared_container->size();
+                auto file = std::fopen(path, "wb");
+                if (file == nullptr) {
+                    throw std::runtime_error("fe::copy_on_write_vector: failed to open the snapshot file");
+                }
+                auto complete = std::fwrite(&header, sizeof(header), 1, file) == 1;
+                if (complete && header.element_count > 0) {
+                    complete = std::fwrite(container().data(), sizeof(value_type),
+                                           container().size(), file) == container().size();
+                }
+                complete = std::fclose(file) == 0 && complete;
+                if (!complete) {
+                    throw std::runtime_error("fe::copy_on_write_vector: failed to write the snapshot file");
+                }
+            }
+
         private:
-            snapshot(std::shared_ptr<container_type> shared_container) noexcept
-                : _shared_container(std::move(shared_container)) {
+            snapshot(std::shared_ptr<container_type> shared_container, std::uint64_t version) noexcept
+                : _shared_container(std::move(shared_container)), _version(version) {
+            }
+
+            /**
+             *  Reads must go through the const surface of the container: a backing
+             *  store such as fe::mapped_vector detaches from its borrowed storage on
+             *  non-const access, which a shared version must never do.
+             */
+            const container_type &container() const noexcept {
+                return *_shared_container;
             }
 
             std::shared_ptr<container_type> _shared_container;
+            std::uint64_t _version;
+
+            friend class copy_on_write_vector;
+        };
+
+        /**
+         *  Represents a read view of one version held by a thread-local pin instead of a
+         *  shared_ptr reference. Taking and dropping the view never touches the version's
+         *  reference count, so under read-mostly contention many readers stop bouncing
+         *  the control block cache line between cores; in exchange the view must stay on
+         *  the thread that took it and should be short-lived, because writers keep every
+         *  pinned version alive and fall back to copying while one is outstanding.
+         */
+        class pinned_snapshot {
+        public:
+            /**
+             *  The type of the constant iterator of the pinned version.
+             */
+            using const_iterator = typename container_type::const_iterator;
+
+            pinned_snapshot(pinned_snapshot &&other) noexcept : _container(other._container), _entry(other._entry) {
+                other._entry = nullptr;
+            }
+
+            pinned_snapshot(const pinned_snapshot &) = delete;
+            pinned_snapshot &operator=(const pinned_snapshot &) = delete;
+            pinned_snapshot &operator=(pinned_snapshot &&) = delete;
+
+            /**
+             *  Releases the pin, allowing writers to reuse or release the version again.
+             */
+            ~pinned_snapshot() {
+                if (_entry != nullptr) {
+                    _entry->store(nullptr);
+                }
+            }
+
+            /**
+             *  Returns the iterator to the beginning.
+             */
+            const_iterator begin() const noexcept {
+                return _container->begin();
+            }
+
+            /**
+             *  Returns the iterator to the end.
+             */
+            const_iterator end() const noexcept {
+                return _container->end();
+            }
+
+            /**
+             *  Gets the n-th element with bounds checking.
+             */
+            const_reference at(size_type n) const {
+                return _container->at(n);
+            }
+
+            /**
+             *  Gets the n-th element.
+             */
+            const_reference operator[](size_type n) const {
+                return (*_container)[n];
+            }
+
+            /**
+             *  Gets the first element.
+             */
+            const_reference front() const {
+                return _container->front();
+            }
+
+            /**
+             *  Gets the last element.
+             */
+            const_reference back() const {
+                return _container->back();
+            }
+
+            /**
+             *  Gets a borrowed raw pointer view of the elements (see element_span).
+             *  The view must not outlive this pinned view.
+             */
+            element_span span() const noexcept {
+                return element_span(_container->data(), _container->data() + _container->size());
+            }
+
+            /**
+             *  Checks whether the container is empty.
+             */
+            bool empty() const noexcept {
+                return _container->empty();
+            }
+
+            /**
+             *  Returns the number of elements.
+             */
+            size_type size() const noexcept {
+                return _container->size();
+            }
+
+        private:
+            pinned_snapshot(const container_type *container, std::atomic<const void *> *entry) noexcept
+                : _container(container), _entry(entry) {
+            }
+
+            const container_type *_container;
+            std::atomic<const void *> *_entry;
 
             friend class copy_on_write_vector;
         };
@@ -542,7 +866,10 @@ namespace fe {
          *  Copy assignment operator.
          */
         copy_on_write_vector &operator=(const copy_on_write_vector &other) {
-            _shared_container = std::make_shared<container_type>(*(other.lock()._shared_container));
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto shared_container = std::atomic_load(&_shared_container);
+            publish_version(std::make_shared<container_type>(*(other.lock()._shared_container)));
+            retire_version(std::move(shared_container));
             return *this;
         }
 
@@ -550,7 +877,10 @@ namespace fe {
          *  Move assignment operator.
          */
         copy_on_write_vector &operator=(copy_on_write_vector &&other) {
-            _shared_container = std::make_shared<container_type>(std::move(*(other.lock()._shared_container)));
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto shared_container = std::atomic_load(&_shared_container);
+            publish_version(std::make_shared<container_type>(std::move(*(other.lock()._shared_container))));
+            retire_version(std::move(shared_container));
             return *this;
         }
 
@@ -560,7 +890,10 @@ namespace fe {
          *  @param other Another container to use as data source.
          */
         copy_on_write_vector &operator=(const container_type &other) {
-            _shared_container = std::make_shared<container_type>(other);
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto shared_container = std::atomic_load(&_shared_container);
+            publish_version(std::make_shared<container_type>(other));
+            retire_version(std::move(shared_container));
             return *this;
         }
 
@@ -570,7 +903,10 @@ namespace fe {
          *  @param other Another container to use as data source.
          */
         copy_on_write_vector &operator=(container_type &&other) {
-            _shared_container = std::make_shared<container_type>(std::move(other));
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto shared_container = std::atomic_load(&_shared_container);
+            publish_version(std::make_shared<container_type>(std::move(other)));
+            retire_version(std::move(shared_container));
             return *this;
         }
 
@@ -580,50 +916,44 @@ namespace fe {
          *  @param initializer_list The initializer list to use as data source.
          */
         copy_on_write_vector &operator=(std::initializer_list<value_type> initializer_list) {
-            _shared_container = std::make_shared<container_type>(std::move(initializer_list));
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto shared_container = std::atomic_load(&_shared_container);
+            publish_version(std::make_shared<container_type>(std::move(initializer_list)));
+            retire_version(std::move(shared_container));
             return *this;
         }
 
         /**
          *  Replaces the contents with the copies of the given value.
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          *
          *  @param count The number of elements.
          *  @param value The value to initialize elements with.
          */
         void assign(size_type count, const_reference value) {
-            std::lock_guard<std::mutex> lock(_mutex);
-            auto copied_container = std::make_shared<container_type>(*_shared_container);
-            copied_container->assign(count, value);
-            _shared_container = std::move(copied_container);
+            mutate([&](container_type &container) { container.assign(count, value); });
         }
 
         /**
          *  Replaces the contents with copies of those in the range [first, last).
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          *
          *  @param first The iterator that appoints the top of the range.
          *  @param last  The iterator that appoints the last next of the range.
          */
         template <class InputIterator>
         void assign(InputIterator first, InputIterator last) {
-            std::lock_guard<std::mutex> lock(_mutex);
-            auto copied_container = std::make_shared<container_type>(*_shared_container);
-            copied_container->assign(first, last);
-            _shared_container = std::move(copied_container);
+            mutate([&](container_type &container) { container.assign(first, last); });
         }
 
         /**
          *  Replaces the contents with the elements from the initializer list.
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          *
          *  @param initializer_list The initializer list to copy the values from.
          */
         void assign(std::initializer_list<value_type> initializer_list) {
-            std::lock_guard<std::mutex> lock(_mutex);
-            auto copied_container = std::make_shared<container_type>(*_shared_container);
-            copied_container->assign(std::move(initializer_list));
-            _shared_container = std::move(copied_container);
+            mutate([&](container_type &container) { container.assign(std::move(initializer_list)); });
         }
 
         /**
@@ -663,9 +993,98 @@ namespace fe {
 
         /**
          *  Gets the snapshot of the current container.
+         *  This operation is wait-free while any snapshot is outstanding; it retries only
+         *  while a writer is running an exclusive in-place mutation (see exclusive_claim).
          */
         snapshot lock() const noexcept {
-            return snapshot(_shared_container);
+            this->record_snapshot();
+            for (;;) {
+                auto version = _version.load();
+                auto shared_container = std::atomic_load(&_shared_container);
+                if (shared_container) {
+                    return snapshot(std::move(shared_container), version);
+                }
+                std::this_thread::yield();
+            }
+        }
+
+        /**
+         *  Gets a pinned read view of the current container.
+         *  Unlike lock(), which copies a shared_ptr and therefore performs an atomic
+         *  read-modify-write on the shared reference count, this acquires the view with a
+         *  plain load of the current version pointer and a store into a slot owned by the
+         *  calling thread, and revalidates the pointer afterwards, so that a version can
+         *  never be released between the load and the pin taking effect.
+         *  The view must not outlive this container and should be dropped promptly:
+         *  while it exists, writers copy instead of mutating in place and keep the pinned
+         *  version alive.
+         */
+        pinned_snapshot pin() const {
+            this->record_snapshot();
+            auto entry = version_pin_registry::acquire_entry();
+            for (;;) {
+                auto current = _current_version.load();
+                if (current == nullptr) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                entry->store(current);
+                if (_current_version.load() == current) {
+                    return pinned_snapshot(current, entry);
+                }
+                entry->store(nullptr);
+            }
+        }
+
+        /**
+         *  Returns the monotonic version of the container: the number of versions
+         *  published since construction. A consumer can compare it against the version
+         *  of its last snapshot instead of comparing contents.
+         */
+        std::uint64_t version() const noexcept {
+            return _version.load();
+        }
+
+        /**
+         *  Blocks until the published version reaches at least the given one and
+         *  returns a snapshot of it, so a consumer wakes exactly when something newer
+         *  than its last snapshot is published instead of polling:
+         *
+         *  ~~~~~~~~~~
+         *  auto snapshot = vec.lock();
+         *  for (;;) {
+         *      snapshot = vec.wait_for_version(snapshot.version() + 1);
+         *      // react to the new contents
+         *  }
+         *  ~~~~~~~~~~
+         *
+         *  Returns immediately when the version has already been reached.
+         *
+         *  @param version The version to wait for.
+         */
+        snapshot wait_for_version(std::uint64_t version) const {
+            {
+                std::unique_lock<std::mutex> guard(_mutex);
+                ++_version_waiters;
+                _version_published.wait(guard, [this, version] { return _version.load() >= version; });
+                --_version_waiters;
+            }
+            return lock();
+        }
+
+        /**
+         *  Registers a callback invoked with the new version number on every
+         *  publication, for consumers that want to be notified rather than to block.
+         *  The callback runs on the mutating thread while it holds the writer lock,
+         *  so it must be short, must not throw and must not call back into this
+         *  container; typically it signals an event loop that then takes a snapshot.
+         *  Watchers cannot be unregistered and must outlive the container.
+         *
+         *  @param watcher The function called with each published version.
+         */
+        void watch(std::function<void(std::uint64_t)> watcher) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _watchers.push_back(std::move(watcher));
         }
 
         /**
@@ -682,6 +1101,17 @@ namespace fe {
             return lock().size();
         }
 
+        /**
+         *  Gets a point-in-time reading of this container's instrumentation counters:
+         *  full copies and bytes copied by mutators, single-pass rebuilds, versions
+         *  published and snapshots taken. All counters stay at zero unless the library
+         *  is compiled with FE_STATS defined; compiled in, each counted operation costs
+         *  one relaxed atomic increment.
+         */
+        container_stats_snapshot stats() const noexcept {
+            return this->container_stats::read();
+        }
+
         /**
          *  Returns the max possible number of elements.
          */
@@ -691,15 +1121,12 @@ namespace fe {
 
         /**
          *  Reserves storage.
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          *
          *  @param new_cap The new capacity of the container.
          */
         void reserve(size_type new_cap) {
-            std::lock_guard<std::mutex> lock(_mutex);
-            auto copied_container = std::make_shared<container_type>(*_shared_container);
-            copied_container->reserve(new_cap);
-            _shared_container = std::move(copied_container);
+            mutate([&](container_type &container) { container.reserve(new_cap); });
         }
 
         /**
@@ -711,73 +1138,91 @@ namespace fe {
 
         /**
          *  Requests the removal of unused capacity.
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          */
         void shrink_to_fit() {
-            std::lock_guard<std::mutex> lock(_mutex);
-            auto copied_container = std::make_shared<container_type>(*_shared_container);
-            copied_container->shrink_to_fit();
-            _shared_container = std::move(copied_container);
+            mutate([&](container_type &container) { container.shrink_to_fit(); });
         }
 
         /**
          *  Clears the contents.
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          */
         void clear() {
             std::lock_guard<std::mutex> lock(_mutex);
-            auto copied_container = std::make_shared<container_type>(
-                std::allocator_traits<allocator_type>::select_on_container_copy_construction(get_allocator()));
-            copied_container->reserve(_shared_container->capacity());
-            _shared_container = std::move(copied_container);
+            exclusive_claim claimed(*this);
+            if (claimed) {
+                claimed->clear();
+                return;
+            }
+            auto shared_container = std::atomic_load(&_shared_container);
+            auto copied_container = fresh_version(
+                std::allocator_traits<allocator_type>::select_on_container_copy_construction(
+                    shared_container->get_allocator()));
+            copied_container->reserve(shared_container->capacity());
+            publish_version(std::move(copied_container));
+            retire_version(std::move(shared_container));
+        }
+
+        /**
+         *  Applies an arbitrary sequence of mutations as a single transaction.
+         *  This operation makes one fresh copy of the underlying container, passes it to the
+         *  given function, and publishes it once after the function returns, so that a burst
+         *  of mutations costs a single allocation and copy instead of one per operation.
+         *  If the function throws, the copy is discarded and the container is left unchanged.
+         *
+         *  ~~~~~~~~~~
+         *  vec.batch_update([](std::vector<int> &container) {
+         *      container.push_back(17);
+         *      container.push_back(19);
+         *      container.erase(container.begin());
+         *  });
+         *  ~~~~~~~~~~
+         *
+         *  @param fn The function that applies the mutations to the copied container.
+         */
+        template <class UnaryFunction>
+        void batch_update(UnaryFunction fn) {
+            mutate([&](container_type &container) { fn(container); });
         }
 
         /**
          *  Inserts value before the given index.
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          *
          *  @param index The index to insert.
          *  @param value The value to insert.
          */
         void insert_at(size_type index, const_reference value) {
-            std::lock_guard<std::mutex> lock(_mutex);
-            auto copied_container = std::make_shared<container_type>(*_shared_container);
-            copied_container->insert(copied_container->begin() + index, value);
-            _shared_container = std::move(copied_container);
+            mutate([&](container_type &container) { container.insert(container.begin() + index, value); });
         }
 
         /**
          *  Inserts value before the given index.
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          *
          *  @param index The index to insert.
          *  @param value The value to insert.
          */
         void insert_at(size_type index, value_type &&value) {
-            std::lock_guard<std::mutex> lock(_mutex);
-            auto copied_container = std::make_shared<container_type>(*_shared_container);
-            copied_container->insert(copied_container->begin() + index, std::move(value));
-            _shared_container = std::move(copied_container);
+            mutate([&](container_type &container) { container.insert(container.begin() + index, std::move(value)); });
         }
 
         /**
          *  Inserts the copies of the value before the given index.
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          *
          *  @param index The index to insert.
          *  @param count The number of elements to insert.
          *  @param value The value to insert.
          */
         void insert_at(size_type index, size_type count, const_reference value) {
-            std::lock_guard<std::mutex> lock(_mutex);
-            auto copied_container = std::make_shared<container_type>(*_shared_container);
-            copied_container->insert(copied_container->begin() + index, count, value);
-            _shared_container = std::move(copied_container);
+            mutate([&](container_type &container) { container.insert(container.begin() + index, count, value); });
         }
 
         /**
          *  Inserts elements from range [first, last) before the given index.
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          *
          *  @param index The index to insert.
          *  @param first The iterator that appoints the top of the range.
@@ -785,44 +1230,35 @@ namespace fe {
          */
         template <class InputIterator>
         void insert_at(size_type index, InputIterator first, InputIterator last) {
-            std::lock_guard<std::mutex> lock(_mutex);
-            auto copied_container = std::make_shared<container_type>(*_shared_container);
-            copied_container->insert(copied_container->begin() + index, first, last);
-            _shared_container = std::move(copied_container);
+            mutate([&](container_type &container) { container.insert(container.begin() + index, first, last); });
         }
 
         /**
          *  Inserts elements from initializer list before the given index.
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          *
          *  @param index            The index to insert.
          *  @param initializer_list The initializer list to insert.
          */
         void insert_at(size_type index, std::initializer_list<value_type> initializer_list) {
-            std::lock_guard<std::mutex> lock(_mutex);
-            auto copied_container = std::make_shared<container_type>(*_shared_container);
-            copied_container->insert(copied_container->begin() + index, std::move(initializer_list));
-            _shared_container = std::move(copied_container);
+            mutate([&](container_type &container) { container.insert(container.begin() + index, std::move(initializer_list)); });
         }
 
         /**
          *  Inserts a new element into the container directly before the given index.
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          *
          *  @param index The index to emplace.
          *  @param args  The arguments to forward to the constructor of the element.
          */
         template <class... ArgTypes>
         void emplace_at(size_type index, ArgTypes &&... args) {
-            std::lock_guard<std::mutex> lock(_mutex);
-            auto copied_container = std::make_shared<container_type>(*_shared_container);
-            copied_container->emplace(copied_container->begin() + index, std::forward<ArgTypes>(args)...);
-            _shared_container = std::move(copied_container);
+            mutate([&](container_type &container) { container.emplace(container.begin() + index, std::forward<ArgTypes>(args)...); });
         }
 
         /**
          *  Replaces the first element that compare equal to old_value with a copy of new_value.
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          *
          *  @param old_value The value to be replaced.
          *  @param new_value The value to replace.
@@ -831,21 +1267,31 @@ namespace fe {
          */
         bool replace(const_reference old_value, const_reference new_value) {
             std::lock_guard<std::mutex> lock(_mutex);
-            auto it = std::find(_shared_container->begin(), _shared_container->end(), old_value);
-            if (it == _shared_container->end()) {
-                return false;
-            } else {
-                auto copied_container = std::make_shared<container_type>(*_shared_container);
-                (*copied_container)[it - _shared_container->begin()] = new_value;
-                _shared_container = std::move(copied_container);
+            exclusive_claim claimed(*this);
+            if (claimed) {
+                auto it = std::find(claimed->begin(), claimed->end(), old_value);
+                if (it == claimed->end()) {
+                    return false;
+                }
+                *it = new_value;
                 return true;
             }
+            auto shared_container = std::atomic_load(&_shared_container);
+            auto it = std::find(shared_container->cbegin(), shared_container->cend(), old_value);
+            if (it == shared_container->cend()) {
+                return false;
+            }
+            auto copied_container = copy_version(*shared_container);
+            (*copied_container)[static_cast<size_type>(it - shared_container->cbegin())] = new_value;
+            publish_version(std::move(copied_container));
+            retire_version(std::move(shared_container));
+            return true;
         }
 
         /**
          *  Replaces the first element that compare equal to old_value with new_value.
          *  If the element was not replaced, the given value is not moved.
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          *
          *  @param old_value The value to be replaced.
          *  @param new_value The value to be moved into the replacement element.
@@ -854,20 +1300,30 @@ namespace fe {
          */
         bool replace(const_reference old_value, value_type &&new_value) {
             std::lock_guard<std::mutex> lock(_mutex);
-            auto it = std::find(_shared_container->begin(), _shared_container->end(), old_value);
-            if (it == _shared_container->end()) {
-                return false;
-            } else {
-                auto copied_container = std::make_shared<container_type>(*_shared_container);
-                (*copied_container)[it - _shared_container->begin()] = std::move(new_value);
-                _shared_container = std::move(copied_container);
+            exclusive_claim claimed(*this);
+            if (claimed) {
+                auto it = std::find(claimed->begin(), claimed->end(), old_value);
+                if (it == claimed->end()) {
+                    return false;
+                }
+                *it = std::move(new_value);
                 return true;
             }
+            auto shared_container = std::atomic_load(&_shared_container);
+            auto it = std::find(shared_container->cbegin(), shared_container->cend(), old_value);
+            if (it == shared_container->cend()) {
+                return false;
+            }
+            auto copied_container = copy_version(*shared_container);
+            (*copied_container)[static_cast<size_type>(it - shared_container->cbegin())] = std::move(new_value);
+            publish_version(std::move(copied_container));
+            retire_version(std::move(shared_container));
+            return true;
         }
 
         /**
          *  Replaces all elements that compare equal to old_value with a copy of new_value.
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          *
          *  @param old_value The value to be replaced.
          *  @param new_value The value to replace.
@@ -876,56 +1332,68 @@ namespace fe {
          */
         size_type replace_all(const_reference old_value, const_reference new_value) {
             std::lock_guard<std::mutex> lock(_mutex);
-            auto copied_container = _shared_container;
-            auto first = _shared_container->begin();
-            auto last = _shared_container->end();
+            exclusive_claim claimed(*this);
+            if (claimed) {
+                size_type result = 0;
+                for (auto it = claimed->begin(); it != claimed->end(); ++it) {
+                    if (*it == old_value) {
+                        *it = new_value;
+                        ++result;
+                    }
+                }
+                return result;
+            }
+            auto shared_container = std::atomic_load(&_shared_container);
+            auto first = std::find(shared_container->cbegin(), shared_container->cend(), old_value);
+            auto last = shared_container->cend();
+            if (first == last) {
+                return 0;
+            }
+            auto copied_container = fresh_version(
+                std::allocator_traits<allocator_type>::select_on_container_copy_construction(
+                    shared_container->get_allocator()));
+            copied_container->reserve(shared_container->size());
+            copied_container->insert(copied_container->end(), shared_container->cbegin(), first);
             size_type result = 0;
             while (first != last) {
                 if (*first == old_value) {
-                    if (result++ == 0) {
-                        copied_container = std::make_shared<container_type>(*copied_container);
-                        first = copied_container->begin() + (first - _shared_container->begin());
-                        last = copied_container->end();
-                    }
-                    (*copied_container)[first - copied_container->begin()] = new_value;
+                    copied_container->push_back(new_value);
+                    ++result;
+                } else {
+                    copied_container->push_back(*first);
                 }
                 ++first;
             }
-            _shared_container = std::move(copied_container);
+            publish_version(std::move(copied_container));
+            retire_version(std::move(shared_container));
             return result;
         }
 
         /**
          *  Replaces the element at the given index with a copy of the given value.
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          *
          *  @param index The index to replace.
          *  @param value The value to replace.
          */
         void replace_at(size_type index, const_reference value) {
-            std::lock_guard<std::mutex> lock(_mutex);
-            auto copied_container = std::make_shared<container_type>(*_shared_container);
-            (*copied_container)[index] = value;
-            _shared_container = std::move(copied_container);
+            mutate([&](container_type &container) { container[index] = value; });
         }
 
         /**
          *  Replaces the element at the given index with the given value.
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          *
          *  @param index The index to replace.
          *  @param value The value to be moved into the replacement element.
          */
         void replace_at(size_type index, value_type &&value) {
-            std::lock_guard<std::mutex> lock(_mutex);
-            auto copied_container = std::make_shared<container_type>(*_shared_container);
-            (*copied_container)[index] = std::move(value);
-            _shared_container = std::move(copied_container);
+            mutate([&](container_type &container) { container[index] = std::move(value); });
         }
 
         /**
          *  Replaces the first element for which the given predicate returns true with a copy of the given value.
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          *
          *  @param pred  The unary predicate which returns ​true if the element value should be replaced.
          *  @param value The value to replace.
@@ -935,21 +1403,31 @@ namespace fe {
         template <class UnaryPredicate>
         bool replace_if(UnaryPredicate pred, const_reference value) {
             std::lock_guard<std::mutex> lock(_mutex);
-            auto it = std::find_if(_shared_container->begin(), _shared_container->end(), std::move(pred));
-            if (it == _shared_container->end()) {
-                return false;
-            } else {
-                auto copied_container = std::make_shared<container_type>(*_shared_container);
-                (*copied_container)[it - _shared_container->begin()] = value;
-                _shared_container = std::move(copied_container);
+            exclusive_claim claimed(*this);
+            if (claimed) {
+                auto it = std::find_if(claimed->begin(), claimed->end(), std::move(pred));
+                if (it == claimed->end()) {
+                    return false;
+                }
+                *it = value;
                 return true;
             }
+            auto shared_container = std::atomic_load(&_shared_container);
+            auto it = std::find_if(shared_container->cbegin(), shared_container->cend(), std::move(pred));
+            if (it == shared_container->cend()) {
+                return false;
+            }
+            auto copied_container = copy_version(*shared_container);
+            (*copied_container)[static_cast<size_type>(it - shared_container->cbegin())] = value;
+            publish_version(std::move(copied_container));
+            retire_version(std::move(shared_container));
+            return true;
         }
 
         /**
          *  Replaces the first element for which the given predicate returns true with the given value.
          *  If the element was not replaced, the given value is not moved.
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          *
          *  @param pred  The unary predicate which returns ​true if the element value should be replaced.
          *  @param value The value to be moved into the replacement element.
@@ -959,20 +1437,30 @@ namespace fe {
         template <class UnaryPredicate>
         bool replace_if(UnaryPredicate pred, value_type &&value) {
             std::lock_guard<std::mutex> lock(_mutex);
-            auto it = std::find_if(_shared_container->begin(), _shared_container->end(), std::move(pred));
-            if (it == _shared_container->end()) {
-                return false;
-            } else {
-                auto copied_container = std::make_shared<container_type>(*_shared_container);
-                (*copied_container)[it - _shared_container->begin()] = std::move(value);
-                _shared_container = std::move(copied_container);
+            exclusive_claim claimed(*this);
+            if (claimed) {
+                auto it = std::find_if(claimed->begin(), claimed->end(), std::move(pred));
+                if (it == claimed->end()) {
+                    return false;
+                }
+                *it = std::move(value);
                 return true;
             }
+            auto shared_container = std::atomic_load(&_shared_container);
+            auto it = std::find_if(shared_container->cbegin(), shared_container->cend(), std::move(pred));
+            if (it == shared_container->cend()) {
+                return false;
+            }
+            auto copied_container = copy_version(*shared_container);
+            (*copied_container)[static_cast<size_type>(it - shared_container->cbegin())] = std::move(value);
+            publish_version(std::move(copied_container));
+            retire_version(std::move(shared_container));
+            return true;
         }
 
         /**
          *  Replaces all elements for which the given predicate returns true with copies of the given value.
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          *
          *  @param pred  The unary predicate which returns ​true if the element value should be replaced.
          *  @param value The value to replace.
@@ -982,28 +1470,90 @@ namespace fe {
         template <class UnaryPredicate>
         size_type replace_all_if(UnaryPredicate pred, const_reference value) {
             std::lock_guard<std::mutex> lock(_mutex);
-            auto copied_container = _shared_container;
-            auto first = _shared_container->begin();
-            auto last = _shared_container->end();
+            exclusive_claim claimed(*this);
+            if (claimed) {
+                size_type result = 0;
+                for (auto it = claimed->begin(); it != claimed->end(); ++it) {
+                    if (pred(*it)) {
+                        *it = value;
+                        ++result;
+                    }
+                }
+                return result;
+            }
+            auto shared_container = std::atomic_load(&_shared_container);
+            auto first = std::find_if(shared_container->cbegin(), shared_container->cend(), pred);
+            auto last = shared_container->cend();
+            if (first == last) {
+                return 0;
+            }
+            auto copied_container = fresh_version(
+                std::allocator_traits<allocator_type>::select_on_container_copy_construction(
+                    shared_container->get_allocator()));
+            copied_container->reserve(shared_container->size());
+            copied_container->insert(copied_container->end(), shared_container->cbegin(), first);
             size_type result = 0;
             while (first != last) {
                 if (pred(*first)) {
-                    if (result++ == 0) {
-                        copied_container = std::make_shared<container_type>(*copied_container);
-                        first = copied_container->begin() + (first - _shared_container->begin());
-                        last = copied_container->end();
-                    }
-                    (*copied_container)[first - copied_container->begin()] = value;
+                    copied_container->push_back(value);
+                    ++result;
+                } else {
+                    copied_container->push_back(*first);
                 }
                 ++first;
             }
-            _shared_container = std::move(copied_container);
+            publish_version(std::move(copied_container));
+            retire_version(std::move(shared_container));
+            return result;
+        }
+
+        /**
+         *  Replaces all elements for which the given predicate returns true with the result of
+         *  the given function applied to the element, building the new version in a single
+         *  forward pass with storage reserved up front.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
+         *
+         *  @param pred The unary predicate which returns ​true if the element value should be transformed.
+         *  @param fn   The unary function whose result replaces the matching element.
+         *
+         *  @return The number of elements transformed.
+         */
+        template <class UnaryPredicate, class UnaryFunction>
+        size_type transform_publish(UnaryPredicate pred, UnaryFunction fn) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            exclusive_claim claimed(*this);
+            if (claimed) {
+                size_type result = 0;
+                for (auto it = claimed->begin(); it != claimed->end(); ++it) {
+                    if (pred(*it)) {
+                        *it = fn(*it);
+                        ++result;
+                    }
+                }
+                return result;
+            }
+            auto shared_container = std::atomic_load(&_shared_container);
+            auto copied_container = fresh_version(
+                std::allocator_traits<allocator_type>::select_on_container_copy_construction(
+                    shared_container->get_allocator()));
+            copied_container->reserve(shared_container->size());
+            size_type result = 0;
+            for (auto first = shared_container->cbegin(); first != shared_container->cend(); ++first) {
+                if (pred(*first)) {
+                    copied_container->push_back(fn(*first));
+                    ++result;
+                } else {
+                    copied_container->push_back(*first);
+                }
+            }
+            publish_version(std::move(copied_container));
+            retire_version(std::move(shared_container));
             return result;
         }
 
         /**
          *  Erases the first element that compare equal to the given value.
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          *
          *  @param value The value to be erased.
          *
@@ -1011,20 +1561,34 @@ namespace fe {
          */
         bool erase(const_reference value) {
             std::lock_guard<std::mutex> lock(_mutex);
-            auto it = std::find(_shared_container->begin(), _shared_container->end(), value);
-            if (it == _shared_container->end()) {
-                return false;
-            } else {
-                auto copied_container = std::make_shared<container_type>(*_shared_container);
-                copied_container->erase(copied_container->begin() + (it - _shared_container->begin()));
-                _shared_container = std::move(copied_container);
+            exclusive_claim claimed(*this);
+            if (claimed) {
+                auto it = std::find(claimed->begin(), claimed->end(), value);
+                if (it == claimed->end()) {
+                    return false;
+                }
+                claimed->erase(it);
                 return true;
             }
+            auto shared_container = std::atomic_load(&_shared_container);
+            auto it = std::find(shared_container->cbegin(), shared_container->cend(), value);
+            if (it == shared_container->cend()) {
+                return false;
+            }
+            auto copied_container = fresh_version(
+                std::allocator_traits<allocator_type>::select_on_container_copy_construction(
+                    shared_container->get_allocator()));
+            copied_container->reserve(shared_container->size() - 1);
+            copied_container->insert(copied_container->end(), shared_container->cbegin(), it);
+            copied_container->insert(copied_container->end(), it + 1, shared_container->cend());
+            publish_version(std::move(copied_container));
+            retire_version(std::move(shared_container));
+            return true;
         }
 
         /**
          *  Erases all elements that compare equal to the given value.
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          *
          *  @param value The value to be erased.
          *
@@ -1032,44 +1596,51 @@ namespace fe {
          */
         size_type erase_all(const_reference value) {
             std::lock_guard<std::mutex> lock(_mutex);
-            auto copied_container = std::make_shared<container_type>(*_shared_container);
-            auto it = std::remove(copied_container->begin(), copied_container->end(), value);
-            auto result = copied_container->end() - it;
-            copied_container->erase(it, copied_container->end());
-            _shared_container = std::move(copied_container);
+            exclusive_claim claimed(*this);
+            if (claimed) {
+                auto it = std::remove(claimed->begin(), claimed->end(), value);
+                auto result = static_cast<size_type>(claimed->end() - it);
+                claimed->erase(it, claimed->end());
+                return result;
+            }
+            auto shared_container = std::atomic_load(&_shared_container);
+            auto copied_container = fresh_version(
+                std::allocator_traits<allocator_type>::select_on_container_copy_construction(
+                    shared_container->get_allocator()));
+            copied_container->reserve(shared_container->size());
+            std::copy_if(shared_container->cbegin(), shared_container->cend(),
+                         std::back_inserter(*copied_container),
+                         [&](const_reference elem) { return !(elem == value); });
+            auto result = shared_container->size() - copied_container->size();
+            publish_version(std::move(copied_container));
+            retire_version(std::move(shared_container));
             return result;
         }
 
         /**
          *  Erases the element at the given index.
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          *
          *  @param index The index to erase.
          */
         void erase_at(size_type index) {
-            std::lock_guard<std::mutex> lock(_mutex);
-            auto copied_container = std::make_shared<container_type>(*_shared_container);
-            copied_container->erase(copied_container->begin() + index);
-            _shared_container = std::move(copied_container);
+            mutate([&](container_type &container) { container.erase(container.begin() + index); });
         }
 
         /**
          *  Erases the elements in the range [first, last).
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          *
          *  @param first The index of the top of the range.
          *  @param last  The index of the last next of the range.
          */
         void erase_range(size_type first, size_type last) {
-            std::lock_guard<std::mutex> lock(_mutex);
-            auto copied_container = std::make_shared<container_type>(*_shared_container);
-            copied_container->erase(copied_container->begin() + first, copied_container->begin() + last);
-            _shared_container = std::move(copied_container);
+            mutate([&](container_type &container) { container.erase(container.begin() + first, container.begin() + last); });
         }
 
         /**
          *  Erases the first element for which the given predicate returns true.
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          *
          *  @param pred The unary predicate which returns ​true if the element value should be erased.
          *
@@ -1078,20 +1649,34 @@ namespace fe {
         template <class UnaryPredicate>
         bool erase_if(UnaryPredicate pred) {
             std::lock_guard<std::mutex> lock(_mutex);
-            auto it = std::find_if(_shared_container->begin(), _shared_container->end(), std::move(pred));
-            if (it == _shared_container->end()) {
-                return false;
-            } else {
-                auto copied_container = std::make_shared<container_type>(*_shared_container);
-                copied_container->erase(copied_container->begin() + (it - _shared_container->begin()));
-                _shared_container = std::move(copied_container);
+            exclusive_claim claimed(*this);
+            if (claimed) {
+                auto it = std::find_if(claimed->begin(), claimed->end(), std::move(pred));
+                if (it == claimed->end()) {
+                    return false;
+                }
+                claimed->erase(it);
                 return true;
             }
+            auto shared_container = std::atomic_load(&_shared_container);
+            auto it = std::find_if(shared_container->cbegin(), shared_container->cend(), std::move(pred));
+            if (it == shared_container->cend()) {
+                return false;
+            }
+            auto copied_container = fresh_version(
+                std::allocator_traits<allocator_type>::select_on_container_copy_construction(
+                    shared_container->get_allocator()));
+            copied_container->reserve(shared_container->size() - 1);
+            copied_container->insert(copied_container->end(), shared_container->cbegin(), it);
+            copied_container->insert(copied_container->end(), it + 1, shared_container->cend());
+            publish_version(std::move(copied_container));
+            retire_version(std::move(shared_container));
+            return true;
         }
 
         /**
          *  Erases all elements for which the given predicate returns true.
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          *
          *  @param pred The unary predicate which returns ​true if the element value should be erased.
          *
@@ -1100,61 +1685,67 @@ namespace fe {
         template <class UnaryPredicate>
         size_type erase_all_if(UnaryPredicate pred) {
             std::lock_guard<std::mutex> lock(_mutex);
-            auto copied_container = std::make_shared<container_type>(*_shared_container);
-            auto it = std::remove_if(copied_container->begin(), copied_container->end(), std::move(pred));
-            auto result = copied_container->end() - it;
-            copied_container->erase(it, copied_container->end());
-            _shared_container = std::move(copied_container);
+            exclusive_claim claimed(*this);
+            if (claimed) {
+                auto it = std::remove_if(claimed->begin(), claimed->end(), std::move(pred));
+                auto result = static_cast<size_type>(claimed->end() - it);
+                claimed->erase(it, claimed->end());
+                return result;
+            }
+            auto shared_container = std::atomic_load(&_shared_container);
+            auto copied_container = fresh_version(
+                std::allocator_traits<allocator_type>::select_on_container_copy_construction(
+                    shared_container->get_allocator()));
+            copied_container->reserve(shared_container->size());
+            std::copy_if(shared_container->cbegin(), shared_container->cend(),
+                         std::back_inserter(*copied_container),
+                         [&](const_reference elem) { return !pred(elem); });
+            auto result = shared_container->size() - copied_container->size();
+            publish_version(std::move(copied_container));
+            retire_version(std::move(shared_container));
             return result;
         }
 
         /**
          *  Adds the element to the end.
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          *
          *  @param value The new element is initialized as a copy of this value.
          */
         void push_back(const_reference value) {
-            std::lock_guard<std::mutex> lock(_mutex);
-            auto copied_container = std::make_shared<container_type>(*_shared_container);
-            copied_container->push_back(value);
-            _shared_container = std::move(copied_container);
+            mutate([&](container_type &container) { container.push_back(value); });
         }
 
         /**
          *  Adds the element to the end.
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          *
          *  @param value The value to be moved into the new element.
          */
         void push_back(value_type &&value) {
-            std::lock_guard<std::mutex> lock(_mutex);
-            auto copied_container = std::make_shared<container_type>(*_shared_container);
-            copied_container->push_back(std::move(value));
-            _shared_container = std::move(copied_container);
+            mutate([&](container_type &container) { container.push_back(std::move(value)); });
         }
 
         /**
          *  Adds elements from range [first, last) to the end.
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          *
          *  @param first The iterator that appoints the top of the range.
          *  @param last  The iterator that appoints the last next of the range.
          */
         template <class InputIterator>
         void push_back(InputIterator first, InputIterator last) {
-            std::lock_guard<std::mutex> lock(_mutex);
-            auto copied_container = std::make_shared<container_type>(*_shared_container);
-            while (first != last) {
-                copied_container->push_back(*first);
-                ++first;
-            }
-            _shared_container = std::move(copied_container);
+            mutate([&](container_type &container) {
+                while (first != last) {
+                    container.push_back(*first);
+                    ++first;
+                }
+            });
         }
 
         /**
          *  Adds the element to the end if not present.
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          *
          *  @param value The new element is initialized as a copy of this value.
          *
@@ -1162,21 +1753,29 @@ namespace fe {
          */
         bool push_back_if_absent(const_reference value) {
             std::lock_guard<std::mutex> lock(_mutex);
-            auto it = std::find(_shared_container->begin(), _shared_container->end(), value);
-            if (it != _shared_container->end()) {
-                return false;
-            } else {
-                auto copied_container = std::make_shared<container_type>(*_shared_container);
-                copied_container->push_back(value);
-                _shared_container = std::move(copied_container);
+            exclusive_claim claimed(*this);
+            if (claimed) {
+                if (std::find(claimed->cbegin(), claimed->cend(), value) != claimed->cend()) {
+                    return false;
+                }
+                claimed->push_back(value);
                 return true;
             }
+            auto shared_container = std::atomic_load(&_shared_container);
+            if (std::find(shared_container->cbegin(), shared_container->cend(), value) != shared_container->cend()) {
+                return false;
+            }
+            auto copied_container = copy_version(*shared_container);
+            copied_container->push_back(value);
+            publish_version(std::move(copied_container));
+            retire_version(std::move(shared_container));
+            return true;
         }
 
         /**
          *  Adds the element to the end if not present.
          *  If the element was not added, the given value is not moved.
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          *
          *  @param value The value to be moved into the new element.
          *
@@ -1184,20 +1783,28 @@ namespace fe {
          */
         bool push_back_if_absent(value_type &&value) {
             std::lock_guard<std::mutex> lock(_mutex);
-            auto it = std::find(_shared_container->begin(), _shared_container->end(), value);
-            if (it != _shared_container->end()) {
-                return false;
-            } else {
-                auto copied_container = std::make_shared<container_type>(*_shared_container);
-                copied_container->push_back(std::move(value));
-                _shared_container = std::move(copied_container);
+            exclusive_claim claimed(*this);
+            if (claimed) {
+                if (std::find(claimed->cbegin(), claimed->cend(), value) != claimed->cend()) {
+                    return false;
+                }
+                claimed->push_back(std::move(value));
                 return true;
             }
+            auto shared_container = std::atomic_load(&_shared_container);
+            if (std::find(shared_container->cbegin(), shared_container->cend(), value) != shared_container->cend()) {
+                return false;
+            }
+            auto copied_container = copy_version(*shared_container);
+            copied_container->push_back(std::move(value));
+            publish_version(std::move(copied_container));
+            retire_version(std::move(shared_container));
+            return true;
         }
 
         /**
          *  Adds elements that are not already contained in this container from range [first, last) to the end.
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          *
          *  @param first The iterator that appoints the top of the range.
          *  @param last  The iterator that appoints the last next of the range.
@@ -1207,203 +1814,705 @@ namespace fe {
         template <class InputIterator>
         size_type push_back_if_absent(InputIterator first, InputIterator last) {
             std::lock_guard<std::mutex> lock(_mutex);
-            auto copied_container = _shared_container;
+            exclusive_claim claimed(*this);
+            if (claimed) {
+                size_type result = 0;
+                while (first != last) {
+                    if (std::find(claimed->cbegin(), claimed->cend(), *first) == claimed->cend()) {
+                        claimed->push_back(*first);
+                        ++result;
+                    }
+                    ++first;
+                }
+                return result;
+            }
+            auto shared_container = std::atomic_load(&_shared_container);
+            auto copied_container = shared_container;
             size_type result = 0;
             while (first != last) {
-                auto it = std::find(copied_container->begin(), copied_container->end(), *first);
-                if (it == copied_container->end()) {
+                auto it = std::find(copied_container->cbegin(), copied_container->cend(), *first);
+                if (it == copied_container->cend()) {
                     if (result++ == 0) {
-                        copied_container = std::make_shared<container_type>(*copied_container);
+                        copied_container = copy_version(*copied_container);
                     }
                     copied_container->push_back(*first);
                 }
                 ++first;
             }
-            _shared_container = std::move(copied_container);
+            publish_version(std::move(copied_container));
+            if (result > 0) {
+                retire_version(std::move(shared_container));
+            }
             return result;
         }
 
         /**
          *  Adds a new element into the container directly to the end.
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          *
          *  @param args The arguments to forward to the constructor of the element.
          */
         template <class... ArgTypes>
         void emplace_back(ArgTypes &&... args) {
-            std::lock_guard<std::mutex> lock(_mutex);
-            auto copied_container = std::make_shared<container_type>(*_shared_container);
-            copied_container->emplace_back(std::forward<ArgTypes>(args)...);
-            _shared_container = std::move(copied_container);
+            mutate([&](container_type &container) { container.emplace_back(std::forward<ArgTypes>(args)...); });
         }
 
         /**
          *  Removes the last element.
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          */
         void pop_back() {
-            std::lock_guard<std::mutex> lock(_mutex);
-            auto copied_container = std::make_shared<container_type>(*_shared_container);
-            copied_container->pop_back();
-            _shared_container = std::move(copied_container);
+            mutate([&](container_type &container) { container.pop_back(); });
         }
 
         /**
          *  Resizes the container.
          *  If the current size is less than the given count, the default-inserted instances of value_type are appended.
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          *
          *  @param count The new size of the container.
          */
         void resize(size_type count) {
-            std::lock_guard<std::mutex> lock(_mutex);
-            auto copied_container = std::make_shared<container_type>(*_shared_container);
-            copied_container->resize(count);
-            _shared_container = std::move(copied_container);
+            mutate([&](container_type &container) { container.resize(count); });
         }
 
         /**
          *  Resizes the container.
          *  If the current size is less than the given count, the copies of the given value are appended.
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          *
          *  @param count The new size of the container.
          *  @param value The value to initialize the new elements with.
          */
         void resize(size_type count, const_reference &value) {
-            std::lock_guard<std::mutex> lock(_mutex);
-            auto copied_container = std::make_shared<container_type>(*_shared_container);
-            copied_container->resize(count, value);
-            _shared_container = std::move(copied_container);
+            mutate([&](container_type &container) { container.resize(count, value); });
         }
 
         /**
          *  Swaps the contents.
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          *
          *  @param other The container to exchange the contents with.
          */
         void swap(copy_on_write_vector &other) {
-            std::lock_guard<std::mutex> lock(_mutex);
-            std::lock_guard<std::mutex> other_lock(other._mutex);
+            std::lock(_mutex, other._mutex);
+            std::lock_guard<std::mutex> lock(_mutex, std::adopt_lock);
+            std::lock_guard<std::mutex> other_lock(other._mutex, std::adopt_lock);
 
-            auto copied_container = std::make_shared<container_type>(*_shared_container);
-            auto other_copied_container = std::make_shared<container_type>(*(other._shared_container));
+            exclusive_claim claimed(*this);
+            exclusive_claim other_claimed(other);
+
+            if (claimed && other_claimed) {
+                claimed->swap(*other_claimed);
+                return;
+            }
+            if (claimed) {
+                auto other_shared_container = std::atomic_load(&other._shared_container);
+                auto other_copied_container = other.copy_version(*other_shared_container);
+                claimed->swap(*other_copied_container);
+                other.publish_version(std::move(other_copied_container));
+                other.retire_version(std::move(other_shared_container));
+                return;
+            }
+            if (other_claimed) {
+                auto shared_container = std::atomic_load(&_shared_container);
+                auto copied_container = copy_version(*shared_container);
+                copied_container->swap(*other_claimed);
+                publish_version(std::move(copied_container));
+                retire_version(std::move(shared_container));
+                return;
+            }
+
+            auto shared_container = std::atomic_load(&_shared_container);
+            auto other_shared_container = std::atomic_load(&other._shared_container);
+            auto copied_container = copy_version(*shared_container);
+            auto other_copied_container = other.copy_version(*other_shared_container);
 
             copied_container->swap(*other_copied_container);
 
-            _shared_container = std::move(copied_container);
-            other._shared_container = std::move(other_copied_container);
+            publish_version(std::move(copied_container));
+            other.publish_version(std::move(other_copied_container));
+            retire_version(std::move(shared_container));
+            other.retire_version(std::move(other_shared_container));
         }
 
         /**
          *  Swaps the contents.
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          *
          *  @param other The container to exchange the contents with.
          */
         void swap(container_type &other) {
-            std::lock_guard<std::mutex> lock(_mutex);
-            auto copied_container = std::make_shared<container_type>(*_shared_container);
-            copied_container->swap(other);
-            _shared_container = std::move(copied_container);
+            mutate([&](container_type &container) { container.swap(other); });
         }
 
         /**
          *  Sorts the elements into ascending order.
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          */
         void sort() {
-            std::lock_guard<std::mutex> lock(_mutex);
-            auto copied_container = std::make_shared<container_type>(*_shared_container);
-            std::sort(copied_container->begin(), copied_container->end());
-            _shared_container = std::move(copied_container);
+            mutate([&](container_type &container) { std::sort(container.begin(), container.end()); });
         }
 
         /**
          *  Sorts the elements into ascending order.
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          *
          *  @param comp The binary function that returns ​true if the first argument is less than the second.
          */
         template <class Compare>
         void sort(Compare comp) {
-            std::lock_guard<std::mutex> lock(_mutex);
-            auto copied_container = std::make_shared<container_type>(*_shared_container);
-            std::sort(copied_container->begin(), copied_container->end(), std::move(comp));
-            _shared_container = std::move(copied_container);
+            mutate([&](container_type &container) { std::sort(container.begin(), container.end(), std::move(comp)); });
         }
 
         /**
          *  Sorts the elements into ascending order, while preserving order between equal elements.
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          */
         void stable_sort() {
-            std::lock_guard<std::mutex> lock(_mutex);
-            auto copied_container = std::make_shared<container_type>(*_shared_container);
-            std::stable_sort(copied_container->begin(), copied_container->end());
-            _shared_container = std::move(copied_container);
+            mutate([&](container_type &container) { std::stable_sort(container.begin(), container.end()); });
         }
 
         /**
          *  Sorts the elements into ascending order, while preserving order between equal elements.
-         *  This operation makes a fresh copy of the underlying container.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
          *
          *  @param comp The binary function that returns ​true if the first argument is less than the second.
          */
         template <class Compare>
         void stable_sort(Compare comp) {
-            std::lock_guard<std::mutex> lock(_mutex);
-            auto copied_container = std::make_shared<container_type>(*_shared_container);
-            std::stable_sort(copied_container->begin(), copied_container->end(), std::move(comp));
-            _shared_container = std::move(copied_container);
+            mutate([&](container_type &container) { std::stable_sort(container.begin(), container.end(), std::move(comp)); });
+        }
+
+        /**
+         *  Sorts the elements into ascending order, partitioning the private copy across
+         *  worker threads and merging the sorted ranges.
+         *  Since the sort operates on a version that no reader can observe yet, the worker
+         *  threads never race with snapshot readers; the underlying container must tolerate
+         *  concurrent access to disjoint element ranges (true for the default std::vector).
+         *  This operation copies the underlying container only when a snapshot is outstanding.
+         *
+         *  @param thread_count The number of worker threads, or 0 for the hardware concurrency.
+         */
+        void parallel_sort(size_type thread_count = 0) {
+            mutate([&](container_type &container) {
+                sort_ranges_parallel(container, std::less<value_type>(), thread_count);
+            });
+        }
+
+        /**
+         *  Sorts the elements into ascending order, partitioning the private copy across
+         *  worker threads and merging the sorted ranges.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
+         *
+         *  @param comp         The binary function that returns ​true if the first argument is less than the second.
+         *  @param thread_count The number of worker threads, or 0 for the hardware concurrency.
+         */
+        template <class Compare,
+                  class = typename std::enable_if<!std::is_integral<Compare>::value, void>::type>
+        void parallel_sort(Compare comp, size_type thread_count = 0) {
+            mutate([&](container_type &container) { sort_ranges_parallel(container, std::move(comp), thread_count); });
+        }
+
+        /**
+         *  Replaces all elements for which the given predicate returns true with copies of the
+         *  given value, partitioning the private copy across worker threads.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
+         *
+         *  @param pred         The unary predicate which returns ​true if the element value should be replaced.
+         *  @param value        The value to replace.
+         *  @param thread_count The number of worker threads, or 0 for the hardware concurrency.
+         *
+         *  @return The number of elements replaced.
+         */
+        template <class UnaryPredicate>
+        size_type parallel_replace_all_if(UnaryPredicate pred, const_reference value, size_type thread_count = 0) {
+            size_type result = 0;
+            mutate([&](container_type &container) {
+                result = for_ranges_parallel(container, thread_count,
+                                             [&](typename container_type::iterator first,
+                                                 typename container_type::iterator last) {
+                                                 size_type replaced = 0;
+                                                 for (; first != last; ++first) {
+                                                     if (pred(*first)) {
+                                                         *first = value;
+                                                         ++replaced;
+                                                     }
+                                                 }
+                                                 return replaced;
+                                             });
+            });
+            return result;
+        }
+
+        /**
+         *  Erases all elements for which the given predicate returns true.
+         *  The predicate pass runs partitioned across worker threads; the surviving ranges are
+         *  then compacted sequentially, since the compaction itself is inherently serial.
+         *  This operation copies the underlying container only when a snapshot is outstanding.
+         *
+         *  @param pred         The unary predicate which returns ​true if the element value should be erased.
+         *  @param thread_count The number of worker threads, or 0 for the hardware concurrency.
+         *
+         *  @return The number of elements erased.
+         */
+        template <class UnaryPredicate>
+        size_type parallel_erase_all_if(UnaryPredicate pred, size_type thread_count = 0) {
+            size_type result = 0;
+            mutate([&](container_type &container) {
+                auto bounds = range_bounds(container.size(), thread_count);
+                std::vector<typename container_type::iterator> range_ends(bounds.size() - 1);
+                std::vector<std::thread> workers;
+                for (size_type i = 0; i + 1 < bounds.size(); ++i) {
+                    workers.emplace_back([&, i] {
+                        range_ends[i] = std::remove_if(container.begin() + bounds[i],
+                                                       container.begin() + bounds[i + 1], pred);
+                    });
+                }
+                for (auto &worker : workers) {
+                    worker.join();
+                }
+                auto kept_end = container.begin();
+                for (size_type i = 0; i + 1 < bounds.size(); ++i) {
+                    auto range_begin = container.begin() + bounds[i];
+                    if (kept_end == range_begin) {
+                        // Nothing has been erased yet, so the range is already in place; moving it
+                        // onto itself would self-move-assign every element.
+                        kept_end = range_ends[i];
+                    } else {
+                        kept_end = std::move(range_begin, range_ends[i], kept_end);
+                    }
+                }
+                result = static_cast<size_type>(container.end() - kept_end);
+                container.erase(kept_end, container.end());
+            });
+            return result;
+        }
+
+        /**
+         *  Describes one contiguous range of elements that differs between two snapshots.
+         *  For a replaced range the indices are valid in both snapshots; for an inserted
+         *  range they are valid in the newer snapshot, and for an erased range in the older.
+         */
+        struct difference {
+            enum kind_type { replaced, inserted, erased };
+
+            /**
+             *  The kind of the change.
+             */
+            kind_type kind;
+
+            /**
+             *  The index of the top of the changed range.
+             */
+            size_type first;
+
+            /**
+             *  The index of the last next of the changed range.
+             */
+            size_type last;
+        };
+
+        /**
+         *  Computes the changed ranges between two snapshots, so that downstream consumers
+         *  can process only the elements that actually changed instead of re-scanning the
+         *  whole container.
+         *  Two snapshots of the same version compare by pointer and cost nothing; otherwise
+         *  the common prefix and suffix are trimmed with an element address comparison first,
+         *  which skips structurally shared storage (such as fe::chunked_vector chunks)
+         *  without touching the element values, and the middle is reported as one replaced
+         *  range plus one inserted or erased range.
+         *
+         *  @param older The snapshot taken earlier.
+         *  @param newer The snapshot taken later.
+         *
+         *  @return The changed ranges, empty if the snapshots are equal.
+         */
+        static std::vector<difference> diff(const snapshot &older, const snapshot &newer) {
+            std::vector<difference> result;
+            if (older._shared_container == newer._shared_container) {
+                return result;
+            }
+            const auto &a = *older._shared_container;
+            const auto &b = *newer._shared_container;
+            auto a_size = a.size();
+            auto b_size = b.size();
+            auto overlap = std::min(a_size, b_size);
+            size_type prefix = 0;
+            while (prefix < overlap && (&a[prefix] == &b[prefix] || a[prefix] == b[prefix])) {
+                ++prefix;
+            }
+            size_type suffix = 0;
+            while (suffix < overlap - prefix && (&a[a_size - 1 - suffix] == &b[b_size - 1 - suffix] ||
+                                                 a[a_size - 1 - suffix] == b[b_size - 1 - suffix])) {
+                ++suffix;
+            }
+            if (overlap - suffix > prefix) {
+                result.push_back(difference{difference::replaced, prefix, overlap - suffix});
+            }
+            if (b_size > a_size) {
+                result.push_back(difference{difference::inserted, a_size - suffix, b_size - suffix});
+            } else if (a_size > b_size) {
+                result.push_back(difference{difference::erased, b_size - suffix, a_size - suffix});
+            }
+            return result;
         }
 
         /**
          *  Compares the contents of two containers.
          */
         friend bool operator==(const copy_on_write_vector &lhs, const copy_on_write_vector &rhs) {
-            return *(lhs._shared_container) == *(rhs._shared_container);
+            return *std::atomic_load(&lhs._shared_container) == *std::atomic_load(&rhs._shared_container);
         }
 
         /**
          *  Compares the contents of two containers.
          */
         friend bool operator!=(const copy_on_write_vector &lhs, const copy_on_write_vector &rhs) {
-            return *(lhs._shared_container) != *(rhs._shared_container);
+            return *std::atomic_load(&lhs._shared_container) != *std::atomic_load(&rhs._shared_container);
         }
 
         /**
          *  Compares the contents of two containers.
          */
         friend bool operator<(const copy_on_write_vector &lhs, const copy_on_write_vector &rhs) {
-            return *(lhs._shared_container) < *(rhs._shared_container);
+            return *std::atomic_load(&lhs._shared_container) < *std::atomic_load(&rhs._shared_container);
         }
 
         /**
          *  Compares the contents of two containers.
          */
         friend bool operator<=(const copy_on_write_vector &lhs, const copy_on_write_vector &rhs) {
-            return *(lhs._shared_container) <= *(rhs._shared_container);
+            return *std::atomic_load(&lhs._shared_container) <= *std::atomic_load(&rhs._shared_container);
         }
 
         /**
          *  Compares the contents of two containers.
          */
         friend bool operator>(const copy_on_write_vector &lhs, const copy_on_write_vector &rhs) {
-            return *(lhs._shared_container) > *(rhs._shared_container);
+            return *std::atomic_load(&lhs._shared_container) > *std::atomic_load(&rhs._shared_container);
         }
 
         /**
          *  Compares the contents of two containers.
          */
         friend bool operator>=(const copy_on_write_vector &lhs, const copy_on_write_vector &rhs) {
-            return *(lhs._shared_container) >= *(rhs._shared_container);
+            return *std::atomic_load(&lhs._shared_container) >= *std::atomic_load(&rhs._shared_container);
         }
 
     private:
-        std::shared_ptr<container_type> _shared_container;
-        std::mutex _mutex;
+        /**
+         *  Claims exclusive ownership of the current version for in-place mutation.
+         *  The current version is atomically detached from the container, so that no new
+         *  snapshot can be taken while the uniqueness check runs; if the calling writer
+         *  holds the only reference and no thread pins the version (see pin), the version
+         *  can be mutated in place with zero copy.
+         *  Otherwise the version is restored immediately and the claim is empty.
+         *  A non-empty claim republishes the version when it goes out of scope, including
+         *  on exception, so that readers never observe the detached state for longer than
+         *  the mutation itself.
+         *  Must be constructed with _mutex held.
+         */
+        class exclusive_claim {
+        public:
+            explicit exclusive_claim(copy_on_write_vector &owner) noexcept : _owner(owner) {
+                auto claimed = std::atomic_exchange(&owner._shared_container, std::shared_ptr<container_type>());
+                owner._current_version.store(nullptr);
+                if (claimed.use_count() == 1 && !version_pin_registry::is_pinned(claimed.get())) {
+                    _container = std::move(claimed);
+                } else {
+                    auto raw = claimed.get();
+                    std::atomic_store(&owner._shared_container, std::move(claimed));
+                    owner._current_version.store(raw);
+                }
+            }
+
+            ~exclusive_claim() {
+                if (_container) {
+                    _owner.publish_version(std::move(_container));
+                }
+            }
+
+            exclusive_claim(const exclusive_claim &) = delete;
+            exclusive_claim &operator=(const exclusive_claim &) = delete;
+
+            explicit operator bool() const noexcept {
+                return static_cast<bool>(_container);
+            }
+
+            container_type &operator*() const noexcept {
+                return *_container;
+            }
+
+            container_type *operator->() const noexcept {
+                return _container.get();
+            }
+
+        private:
+            copy_on_write_vector &_owner;
+            std::shared_ptr<container_type> _container;
+        };
+
+        /**
+         *  Applies the given mutation to the current version in place when no snapshot is
+         *  outstanding, and to a fresh copy that is published afterwards otherwise, so that
+         *  the copy cost is only paid when a snapshot actually exists.
+         */
+        template <class UnaryFunction>
+        void mutate(UnaryFunction fn) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            exclusive_claim claimed(*this);
+            if (claimed) {
+                fn(*claimed);
+                return;
+            }
+            auto shared_container = std::atomic_load(&_shared_container);
+            auto copied_container = copy_version(*shared_container);
+            fn(*copied_container);
+            publish_version(std::move(copied_container));
+            retire_version(std::move(shared_container));
+        }
+
+        /**
+         *  Splits [0, size) into up to thread_count ranges of near-equal length and returns
+         *  the range boundaries. A thread_count of 0 means the hardware concurrency.
+         */
+        static std::vector<difference_type> range_bounds(size_type size, size_type thread_count) {
+            if (thread_count == 0) {
+                thread_count = std::thread::hardware_concurrency();
+            }
+            if (thread_count < 1) {
+                thread_count = 1;
+            }
+            if (size > 0 && thread_count > size) {
+                thread_count = size;
+            }
+            std::vector<difference_type> bounds;
+            bounds.reserve(thread_count + 1);
+            for (size_type i = 0; i <= thread_count; ++i) {
+                bounds.push_back(static_cast<difference_type>(i * (size / thread_count) +
+                                                              std::min(i, size % thread_count)));
+            }
+            return bounds;
+        }
+
+        /**
+         *  Applies the given function to up to thread_count disjoint ranges of the container
+         *  in worker threads and returns the sum of the per-range results.
+         */
+        template <class RangeFunction>
+        static size_type for_ranges_parallel(container_type &container, size_type thread_count, RangeFunction fn) {
+            auto bounds = range_bounds(container.size(), thread_count);
+            std::vector<size_type> results(bounds.size() - 1, 0);
+            std::vector<std::thread> workers;
+            for (std::size_t i = 0; i + 1 < bounds.size(); ++i) {
+                workers.emplace_back(
+                    [&, i] { results[i] = fn(container.begin() + bounds[i], container.begin() + bounds[i + 1]); });
+            }
+            for (auto &worker : workers) {
+                worker.join();
+            }
+            size_type total = 0;
+            for (auto result : results) {
+                total += result;
+            }
+            return total;
+        }
+
+        /**
+         *  Sorts up to thread_count disjoint ranges of the container in worker threads and
+         *  merges neighbouring sorted ranges pairwise, also in worker threads, until the
+         *  whole container is sorted.
+         */
+        template <class Compare>
+        static void sort_ranges_parallel(container_type &container, Compare comp, size_type thread_count) {
+            auto bounds = range_bounds(container.size(), thread_count);
+            auto range_count = bounds.size() - 1;
+            if (range_count < 2) {
+                std::sort(container.begin(), container.end(), std::move(comp));
+                return;
+            }
+            {
+                std::vector<std::thread> workers;
+                for (std::size_t i = 0; i < range_count; ++i) {
+                    workers.emplace_back(
+                        [&, i] { std::sort(container.begin() + bounds[i], container.begin() + bounds[i + 1], comp); });
+                }
+                for (auto &worker : workers) {
+                    worker.join();
+                }
+            }
+            for (std::size_t width = 1; width < range_count; width *= 2) {
+                std::vector<std::thread> workers;
+                for (std::size_t i = 0; i + width < range_count; i += width * 2) {
+                    workers.emplace_back([&, i, width] {
+                        std::inplace_merge(container.begin() + bounds[i], container.begin() + bounds[i + width],
+                                           container.begin() + bounds[std::min(i + width * 2, range_count)], comp);
+                    });
+                }
+                for (auto &worker : workers) {
+                    worker.join();
+                }
+            }
+        }
+
+        /**
+         *  Makes a new version holding a copy of the given source.
+         *  The retired spare version is recycled when available, reusing its storage, so
+         *  that steady-state writes stop round-tripping through the allocator; otherwise
+         *  the version and its control block are allocated in one block from the user
+         *  allocator via allocate_shared.
+         *  Must be called with _mutex held.
+         */
+        std::shared_ptr<container_type> copy_version(const container_type &source) {
+            this->record_copy(static_cast<std::uint64_t>(source.size()) * sizeof(value_type));
+            if (_spare_container && _spare_container.use_count() == 1) {
+                auto recycled = std::move(_spare_container);
+                *recycled = source;
+                return recycled;
+            }
+            using version_allocator =
+                typename std::allocator_traits<allocator_type>::template rebind_alloc<container_type>;
+            return std::allocate_shared<container_type>(version_allocator(source.get_allocator()), source);
+        }
+
+        /**
+         *  Makes a new empty version with the given allocator, recycling the spare version
+         *  (and its capacity) when available.
+         *  Must be called with _mutex held.
+         */
+        std::shared_ptr<container_type> fresh_version(const allocator_type &allocator) {
+            this->record_rebuild();
+            if (_spare_container && _spare_container.use_count() == 1) {
+                auto recycled = std::move(_spare_container);
+                recycled->clear();
+                return recycled;
+            }
+            using version_allocator =
+                typename std::allocator_traits<allocator_type>::template rebind_alloc<container_type>;
+            return std::allocate_shared<container_type>(version_allocator(allocator), allocator);
+        }
+
+        /**
+         *  Publishes the given version as the current one, keeping the raw version pointer
+         *  read by pinned readers in step with the shared_ptr slot, then bumps the version
+         *  counter and wakes the version watchers — every mutator funnels through here, so
+         *  no publication can slip past a waiting consumer.
+         *  Must be called with _mutex held.
+         */
+        void publish_version(std::shared_ptr<container_type> version) {
+            this->record_publication();
+            auto raw = version.get();
+            std::atomic_store(&_shared_container, std::move(version));
+            _current_version.store(raw);
+            auto published = _version.fetch_add(1) + 1;
+            if (_version_waiters > 0) {
+                _version_published.notify_all();
+            }
+            for (auto &watcher : _watchers) {
+                watcher(published);
+            }
+        }
+
+        /**
+         *  Keeps the displaced version as the spare for the next copy when no snapshot
+         *  still references it; a version that outlived its snapshots costs one buffer of
+         *  idle memory in exchange for allocation-free steady-state writes.
+         *  A version that some thread still pins must neither be recycled nor released,
+         *  so it is parked in the retired list instead and swept on later retirements,
+         *  once the pins are gone.
+         *  Must be called with _mutex held.
+         */
+        void retire_version(std::shared_ptr<container_type> &&retired) {
+            _retired_versions.erase(std::remove_if(_retired_versions.begin(), _retired_versions.end(),
+                                                   [](const std::shared_ptr<container_type> &version) {
+                                                       return !version_pin_registry::is_pinned(version.get());
+                                                   }),
+                                    _retired_versions.end());
+            if (version_pin_registry::is_pinned(retired.get())) {
+                _retired_versions.push_back(std::move(retired));
+                return;
+            }
+            if (retired.use_count() == 1) {
+                _spare_container = std::move(retired);
+            }
+        }
+
+        /**
+         *  Registry of the per-thread pin slots behind pin().
+         *  Each reading thread owns a small set of slots that no other thread ever writes,
+         *  so taking a pinned view is a shared load plus a thread-local store, with no
+         *  shared atomic read-modify-write; writers scan every slot before mutating a
+         *  version in place or before reusing or releasing a displaced one.
+         *  Slots are never returned to the system; a thread that exits leaves its (empty)
+         *  slots behind for the lifetime of the process, which keeps the scan loop free of
+         *  lifetime bookkeeping.
+         */
+        class version_pin_registry {
+        public:
+            struct pin_slot {
+                pin_slot() noexcept : next(nullptr) {
+                    for (auto &entry : entries) {
+                        entry.store(nullptr, std::memory_order_relaxed);
+                    }
+                }
+
+                std::atomic<const void *> entries[8];
+                pin_slot *next;
+            };
+
+            /**
+             *  Returns a free pin entry of the calling thread, growing the thread's slot
+             *  set when every entry is occupied by an outstanding pinned view.
+             */
+            static std::atomic<const void *> *acquire_entry() {
+                static thread_local std::vector<pin_slot *> slots;
+                for (auto slot : slots) {
+                    for (auto &entry : slot->entries) {
+                        if (entry.load(std::memory_order_relaxed) == nullptr) {
+                            return &entry;
+                        }
+                    }
+                }
+                auto slot = new pin_slot();
+                slots.push_back(slot);
+                auto &list = head();
+                slot->next = list.load();
+                while (!list.compare_exchange_weak(slot->next, slot)) {
+                }
+                return &slot->entries[0];
+            }
+
+            /**
+             *  Checks whether any thread currently pins the given version.
+             */
+            static bool is_pinned(const void *version) {
+                for (auto slot = head().load(); slot != nullptr; slot = slot->next) {
+                    for (auto &entry : slot->entries) {
+                        if (entry.load() == version) {
+                            return true;
+                        }
+                    }
+                }
+                return false;
+            }
+
+        private:
+            static std::atomic<pin_slot *> &head() {
+                static std::atomic<pin_slot *> list(nullptr);
+                return list;
+            }
+        };
+
+        mutable std::shared_ptr<container_type> _shared_container;
+        mutable std::atomic<const container_type *> _current_version{_shared_container.get()};
+        std::shared_ptr<container_type> _spare_container;
+        std::vector<std::shared_ptr<container_type>> _retired_versions;
+        std::atomic<std::uint64_t> _version{0};
+        std::vector<std::function<void(std::uint64_t)>> _watchers;
+        mutable std::condition_variable _version_published;
+        mutable std::size_t _version_waiters{0};
+        mutable std::mutex _mutex;
     };
 }
 
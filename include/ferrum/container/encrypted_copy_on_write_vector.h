@@ -0,0 +1,403 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Daisuke Itabashi (https://github.com/idaisuke/ferrum)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef __ferrum__encrypted_copy_on_write_vector__
+#define __ferrum__encrypted_copy_on_write_vector__
+
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "copy_on_write_vector.h"
+
+namespace fe {
+
+    /**
+     *  Represents a thread-safe sequence container of encrypted values, bridging
+     *  fe::copy_on_write_vector and the cipher classes. The vector stores the raw
+     *  encrypted blocks plus one cipher shared by every element and every copy of the
+     *  container, so copy-on-write copies are bitwise copies of trivially copyable
+     *  blocks instead of a decrypt/re-encrypt round trip per element; elements are
+     *  decrypted on read.
+     *
+     *  A copy_on_write_vector<cipher_value<T, Cipher>> by contrast re-encrypts every
+     *  element through the cipher_value copy constructor on each copy-on-write copy.
+     *
+     *  The container itself is thread-safe, but reads decrypt through the one cipher
+     *  instance shared by every copy, snapshot and iterator, so the cipher's own
+     *  concurrency caveats apply: with fe::aes_cipher on the EVP backend the contexts
+     *  are mutated per call and concurrent readers need external synchronization (see
+     *  fe::shared_aes_cipher), while the AES-NI backend and the xor ciphers are
+     *  stateless per call and safe to read concurrently.
+     *
+     *  ~~~~~~~~~~
+     *  fe::encrypted_copy_on_write_vector<int, fe::xor_cipher> vec = {2, 3, 5, 7};
+     *
+     *  auto snapshot = vec.lock();
+     *  int elem = snapshot[2];
+     *
+     *  vec.push_back(11);
+     *  ~~~~~~~~~~
+     *
+     *  @tparam T      The type of the unencrypted elements.
+     *  @tparam Cipher A cryptographic cipher for encryption and decryption.
+     */
+    template <class T, template <class> class Cipher>
+    class encrypted_copy_on_write_vector {
+    public:
+        /**
+         *  The type of the unencrypted elements.
+         */
+        using value_type = T;
+
+        /**
+         *  The type of the cipher shared by all elements.
+         */
+        using cipher_type = Cipher<T>;
+
+        /**
+         *  The type of the encrypted elements.
+         */
+        using encrypted_type = typename cipher_type::encrypted_type;
+
+        /**
+         *  The type of the underlying container of encrypted elements.
+         */
+        using container_type = copy_on_write_vector<encrypted_type>;
+
+        /**
+         *  The unsigned integral type of the size of the underlying container.
+         */
+        using size_type = typename container_type::size_type;
+
+        class snapshot;
+
+        /**
+         *  Represents a constant iterator that decrypts elements on dereference.
+         */
+        class const_decrypting_iterator
+            : public std::iterator<std::input_iterator_tag, value_type, std::ptrdiff_t, const value_type *,
+                                   value_type> {
+        public:
+            value_type operator*() const {
+                return _cipher->decrypt(_snapshot[_index]);
+            }
+
+            const_decrypting_iterator &operator++() {
+                ++_index;
+                return *this;
+            }
+
+            const_decrypting_iterator operator++(int) {
+                auto itr = *this;
+                ++(*this);
+                return itr;
+            }
+
+            friend bool operator==(const const_decrypting_iterator &lhs, const const_decrypting_iterator &rhs) {
+                return lhs._index == rhs._index;
+            }
+
+            friend bool operator!=(const const_decrypting_iterator &lhs, const const_decrypting_iterator &rhs) {
+                return lhs._index != rhs._index;
+            }
+
+        private:
+            const_decrypting_iterator(std::shared_ptr<const cipher_type> cipher,
+                                      typename container_type::snapshot snapshot, size_type index)
+                : _cipher(std::move(cipher)), _snapshot(std::move(snapshot)), _index(index) {
+            }
+
+            std::shared_ptr<const cipher_type> _cipher;
+            typename container_type::snapshot _snapshot;
+            size_type _index;
+
+            friend class snapshot;
+        };
+
+        /**
+         *  The type of the constant iterator.
+         */
+        using iterator = const_decrypting_iterator;
+
+        /**
+         *  The alias of iterator.
+         */
+        using const_iterator = iterator;
+
+        /**
+         *  Represents a snapshot of this container from a certain time.
+         */
+        class snapshot {
+        public:
+            /**
+             *  Returns the iterator to the beginning.
+             */
+            iterator begin() const {
+                return iterator(_cipher, _snapshot, 0);
+            }
+
+            /**
+             *  Returns the iterator to the end.
+             */
+            iterator end() const {
+                return iterator(_cipher, _snapshot, _snapshot.size());
+            }
+
+            /**
+             *  Gets the decrypted n-th element with bounds checking.
+             */
+            value_type at(size_type n) const {
+                return _cipher->decrypt(_snapshot.at(n));
+            }
+
+            /**
+             *  Gets the decrypted n-th element.
+             */
+            value_type operator[](size_type n) const {
+                return _cipher->decrypt(_snapshot[n]);
+            }
+
+            /**
+             *  Checks whether the container is empty.
+             */
+            bool empty() const noexcept {
+                return _snapshot.empty();
+            }
+
+            /**
+             *  Returns the number of elements.
+             */
+            size_type size() const noexcept {
+                return _snapshot.size();
+            }
+
+            /**
+             *  Decrypts all elements into the given span, which must hold size() values.
+             *  Uses the cipher's bulk kernel when it provides one, so cheap ciphers decrypt
+             *  the whole snapshot vectorized.
+             */
+            void decrypt(value_type *out) const {
+                decrypt_all(out, typename has_bulk_kernels<cipher_type>::type());
+            }
+
+        private:
+            snapshot(std::shared_ptr<const cipher_type> cipher, typename container_type::snapshot snap)
+                : _cipher(std::move(cipher)), _snapshot(std::move(snap)) {
+            }
+
+            void decrypt_all(value_type *out, std::true_type) const {
+                _cipher->decrypt_n(_snapshot.data(), _snapshot.size(), out);
+            }
+
+            void decrypt_all(value_type *out, std::false_type) const {
+                auto size = _snapshot.size();
+                for (size_type i = 0; i < size; ++i) {
+                    out[i] = _cipher->decrypt(_snapshot[i]);
+                }
+            }
+
+            std::shared_ptr<const cipher_type> _cipher;
+            typename container_type::snapshot _snapshot;
+
+            friend class encrypted_copy_on_write_vector;
+        };
+
+        /**
+         *  Default constructor. Constructs an empty container with a fresh cipher.
+         */
+        encrypted_copy_on_write_vector() : _cipher(std::make_shared<const cipher_type>()) {
+        }
+
+        /**
+         *  Constructs an empty container with the given cipher.
+         *
+         *  @param cipher The cipher to encrypt and decrypt the elements with.
+         */
+        explicit encrypted_copy_on_write_vector(const cipher_type &cipher)
+            : _cipher(std::make_shared<const cipher_type>(cipher)) {
+        }
+
+        /**
+         *  Constructs the container with the encrypted contents of the range [first, last).
+         *
+         *  @param first, last The range to encrypt the elements from.
+         */
+        template <class InputIterator>
+        encrypted_copy_on_write_vector(InputIterator first, InputIterator last)
+            : _cipher(std::make_shared<const cipher_type>()) {
+            assign(first, last);
+        }
+
+        /**
+         *  Constructs the container with the encrypted contents of the initializer list.
+         *
+         *  @param initializer_list The initializer list to encrypt the elements from.
+         */
+        encrypted_copy_on_write_vector(std::initializer_list<value_type> initializer_list)
+            : encrypted_copy_on_write_vector(initializer_list.begin(), initializer_list.end()) {
+        }
+
+        /**
+         *  Copy constructor. The encrypted blocks are copied bitwise and the cipher is
+         *  shared with the other container, so no element is re-encrypted.
+         *
+         *  @param other Another container to copy the elements from.
+         */
+        encrypted_copy_on_write_vector(const encrypted_copy_on_write_vector &other)
+            : _cipher(other._cipher), _container(other._container) {
+        }
+
+        /**
+         *  Move constructor.
+         */
+        encrypted_copy_on_write_vector(encrypted_copy_on_write_vector &&other) noexcept
+            : _cipher(std::move(other._cipher)), _container(std::move(other._container)) {
+        }
+
+        /**
+         *  Copy assignment operator. Shares the other container's cipher like the copy
+         *  constructor.
+         */
+        encrypted_copy_on_write_vector &operator=(const encrypted_copy_on_write_vector &other) {
+            _cipher = other._cipher;
+            _container = other._container;
+            return *this;
+        }
+
+        /**
+         *  Move assignment operator.
+         */
+        encrypted_copy_on_write_vector &operator=(encrypted_copy_on_write_vector &&other) {
+            _cipher = std::move(other._cipher);
+            _container = std::move(other._container);
+            return *this;
+        }
+
+        /**
+         *  Replaces the contents with the encrypted values of the range [first, last).
+         *
+         *  @param first, last The range to encrypt the elements from.
+         */
+        template <class InputIterator>
+        void assign(InputIterator first, InputIterator last) {
+            auto cipher = _cipher;
+            _container.batch_update([&first, &last, &cipher](std::vector<encrypted_type> &container) {
+                container.clear();
+                while (first != last) {
+                    container.push_back(cipher->encrypt(*first));
+                    ++first;
+                }
+            });
+        }
+
+        /**
+         *  Gets the snapshot of the current container.
+         */
+        snapshot lock() const noexcept {
+            return snapshot(_cipher, _container.lock());
+        }
+
+        /**
+         *  Gets the decrypted n-th element with bounds checking.
+         */
+        value_type at(size_type n) const {
+            return _cipher->decrypt(_container.at(n));
+        }
+
+        /**
+         *  Checks whether the container is empty.
+         */
+        bool empty() const noexcept {
+            return _container.empty();
+        }
+
+        /**
+         *  Returns the number of elements.
+         */
+        size_type size() const noexcept {
+            return _container.size();
+        }
+
+        /**
+         *  Removes all elements.
+         */
+        void clear() {
+            _container.clear();
+        }
+
+        /**
+         *  Encrypts the given value and appends it.
+         *
+         *  @param value The value to encrypt and append.
+         */
+        void push_back(const value_type &value) {
+            _container.push_back(_cipher->encrypt(value));
+        }
+
+        /**
+         *  Removes the last element.
+         */
+        void pop_back() {
+            _container.pop_back();
+        }
+
+        /**
+         *  Encrypts the given value into the n-th element.
+         *
+         *  @param n     The index of the element.
+         *  @param value The value to encrypt and store.
+         */
+        void set(size_type n, const value_type &value) {
+            auto encrypted = _cipher->encrypt(value);
+            _container.batch_update(
+                [n, &encrypted](std::vector<encrypted_type> &container) { container.at(n) = encrypted; });
+        }
+
+    private:
+        /**
+         *  Detects whether the cipher provides encrypt_n/decrypt_n bulk kernels.
+         */
+        template <class C>
+        class has_bulk_kernels {
+            template <class U>
+            static auto test(const U *cipher)
+                -> decltype(cipher->decrypt_n(static_cast<const typename U::encrypted_type *>(nullptr),
+                                              std::size_t(0), static_cast<typename U::value_type *>(nullptr)),
+                            std::true_type());
+
+            template <class U>
+            static std::false_type test(...);
+
+        public:
+            using type = decltype(test<C>(nullptr));
+        };
+
+        std::shared_ptr<const cipher_type> _cipher;
+        container_type _container;
+    };
+}
+
+#endif /* defined(__ferrum__encrypted_copy_on_write_vector__) */
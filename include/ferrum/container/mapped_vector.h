@@ -0,0 +1,1032 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Daisuke Itabashi (https://github.com/idaisuke/ferrum)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef __ferrum__mapped_vector__
+#define __ferrum__mapped_vector__
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "copy_on_write_vector.h"
+
+namespace fe {
+
+    /**
+     *  Owns one read-only memory mapping of a file, unmapped on destruction.
+     *  Shared between the fe::mapped_vector instances borrowing elements from it, so
+     *  the mapping lives exactly as long as the last borrower.
+     */
+    class mapped_file {
+    public:
+        /**
+         *  Opens and maps the whole file read-only.
+         *  Throws std::runtime_error when the file cannot be opened or mapped.
+         *
+         *  @param path The path of the file to map.
+         */
+        explicit mapped_file(const char *path) {
+            auto descriptor = ::open(path, O_RDONLY);
+            if (descriptor == -1) {
+                throw std::runtime_error("fe::mapped_file: failed to open the file");
+            }
+            struct stat status;
+            if (::fstat(descriptor, &status) == -1) {
+                ::close(descriptor);
+                throw std::runtime_error("fe::mapped_file: failed to stat the file");
+            }
+            _length = static_cast<std::size_t>(status.st_size);
+            _address = ::mmap(nullptr, _length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+            ::close(descriptor);
+            if (_address == MAP_FAILED) {
+                throw std::runtime_error("fe::mapped_file: failed to map the file");
+            }
+        }
+
+        mapped_file(const mapped_file &) = delete;
+        mapped_file &operator=(const mapped_file &) = delete;
+
+        /**
+         *  Destructor. Unmaps the file.
+         */
+        ~mapped_file() {
+            ::munmap(_address, _length);
+        }
+
+        /**
+         *  Gets the address of the mapping.
+         */
+        const void *address() const noexcept {
+            return _address;
+        }
+
+        /**
+         *  Returns the length of the mapping in bytes.
+         */
+        std::size_t length() const noexcept {
+            return _length;
+        }
+
+    private:
+        void *_address;
+        std::size_t _length;
+    };
+
+    /**
+     *  Represents a contiguous vector that can borrow its elements from a read-only
+     *  memory mapping of a saved snapshot file and detaches to allocator-acquired
+     *  storage on the first operation that needs to write.
+     *  Mapping a multi-gigabyte checkpoint back in therefore costs page faults on the
+     *  elements actually read instead of a parse of the whole file, and the copy of
+     *  the mapped elements is paid lazily, only if the container is ever mutated.
+     *
+     *  This container is intended as the backing store of fe::copy_on_write_vector,
+     *  selectable through its Container template parameter: moving a mapped instance
+     *  in adopts the mapping as the immutable first version, and the first mutation
+     *  copies it the same way any version copy does.
+     *
+     *  ~~~~~~~~~~
+     *  fe::copy_on_write_vector<int> vec = {2, 3, 5, 7};
+     *  vec.lock().save("primes.snapshot");
+     *
+     *  // later: O(page-fault) startup instead of an O(n) parse
+     *  fe::mapped_copy_on_write_vector<int> reloaded(fe::mapped_vector<int>::map("primes.snapshot"));
+     *  ~~~~~~~~~~
+     *
+     *  @tparam T         The type of the elements.
+     *  @tparam Allocator An allocator that is used to acquire memory once the
+     *                    container detaches from the mapping.
+     */
+    template <class T, class Allocator = std::allocator<T>>
+    class mapped_vector {
+    public:
+        /**
+         *  The type of the elements.
+         */
+        using value_type = T;
+
+        /**
+         *  The type of the allocator.
+         */
+        using allocator_type = Allocator;
+
+        /**
+         *  The unsigned integral type of the size of the container.
+         */
+        using size_type = std::size_t;
+
+        /**
+         *  The signed integral type of the distance of the iterators.
+         */
+        using difference_type = std::ptrdiff_t;
+
+        /**
+         *  The type of the reference of the elements.
+         */
+        using reference = value_type &;
+
+        /**
+         *  The type of the constant reference of the elements.
+         */
+        using const_reference = const value_type &;
+
+        /**
+         *  The type of the pointer of the elements.
+         */
+        using pointer = typename std::allocator_traits<allocator_type>::pointer;
+
+        /**
+         *  The type of the constant pointer of the elements.
+         */
+        using const_pointer = typename std::allocator_traits<allocator_type>::const_pointer;
+
+        /**
+         *  The type of the iterator, a raw element pointer.
+         */
+        using iterator = value_type *;
+
+        /**
+         *  The type of the constant iterator, a raw element pointer.
+         */
+        using const_iterator = const value_type *;
+
+        /**
+         *  The type of the reverse iterator.
+         */
+        using reverse_iterator = std::reverse_iterator<iterator>;
+
+        /**
+         *  The type of the constant reverse iterator.
+         */
+        using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+        /**
+         *  Maps the given snapshot file (see copy_on_write_vector::snapshot::save) and
+         *  returns a container borrowing its elements straight out of the mapping.
+         *  Throws std::runtime_error when the file cannot be mapped or is not a
+         *  snapshot of this value type.
+         *
+         *  @param path The path of the file to map.
+         */
+        static mapped_vector map(const char *path) {
+            static_assert(std::is_trivially_copyable<value_type>::value,
+                          "map requires a trivially copyable element type");
+            static_assert(alignof(value_type) <= sizeof(snapshot_file_header),
+                          "map requires the element alignment to fit the header padding");
+            auto file = std::make_shared<const mapped_file>(path);
+            if (file->length() < sizeof(snapshot_file_header)) {
+                throw std::runtime_error("fe::mapped_vector: not a snapshot file");
+            }
+            snapshot_file_header header;
+            std::memcpy(&header, file->address(), sizeof(header));
+            if (std::memcmp(header.magic, "ferrumcw", sizeof(header.magic)) != 0) {
+                throw std::runtime_error("fe::mapped_vector: not a snapshot file");
+            }
+            if (header.element_size != sizeof(value_type)) {
+                throw std::runtime_error("fe::mapped_vector: element size mismatch");
+            }
+            if ((file->length() - sizeof(header)) / sizeof(value_type) < header.element_count) {
+                throw std::runtime_error("fe::mapped_vector: truncated snapshot file");
+            }
+            mapped_vector result;
+            auto bytes = static_cast<const char *>(file->address()) + sizeof(header);
+            result._data = reinterpret_cast<pointer>(const_cast<char *>(bytes));
+            result._size = static_cast<size_type>(header.element_count);
+            result._capacity = result._size;
+            result._mapping = std::move(file);
+            return result;
+        }
+
+        /**
+         *  Default constructor. Constructs an empty container.
+         */
+        mapped_vector() noexcept : mapped_vector(allocator_type()) {
+        }
+
+        /**
+         *  Constructs an empty container.
+         *
+         *  @param allocator The user supplied allocator.
+         */
+        explicit mapped_vector(const allocator_type &allocator) noexcept
+            : _allocator(allocator), _data(nullptr), _size(0), _capacity(0) {
+        }
+
+        /**
+         *  Constructs the container with the copies of elements with the given value.
+         *
+         *  @param count     The number of elements.
+         *  @param value     The value to initialize elements with.
+         *  @param allocator The user supplied allocator.
+         */
+        mapped_vector(size_type count, const_reference value, const allocator_type &allocator = allocator_type())
+            : mapped_vector(allocator) {
+            resize(count, value);
+        }
+
+        /**
+         *  Constructs the container with the given number of the default-inserted elements.
+         *
+         *  @param count The number of elements.
+         */
+        explicit mapped_vector(size_type count) : mapped_vector() {
+            resize(count);
+        }
+
+        /**
+         *  Constructs the container with the contents of the range [first, last).
+         *
+         *  @param first, last The range to copy the elements from.
+         *  @param allocator   The user supplied allocator.
+         */
+        template <class InputIterator,
+                  class = typename std::enable_if<!std::is_integral<InputIterator>::value>::type>
+        mapped_vector(InputIterator first, InputIterator last, const allocator_type &allocator = allocator_type())
+            : mapped_vector(allocator) {
+            while (first != last) {
+                push_back(*first);
+                ++first;
+            }
+        }
+
+        /**
+         *  Copy constructor. The copy owns its elements even when the other borrows
+         *  them from a mapping.
+         *
+         *  @param other Another container to copy the elements from.
+         */
+        mapped_vector(const mapped_vector &other) : mapped_vector(other._allocator) {
+            append_copies(other);
+        }
+
+        /**
+         *  Constructs the container with the copies of the elements of the other.
+         *
+         *  @param other     Another container to copy the elements from.
+         *  @param allocator The user supplied allocator.
+         */
+        mapped_vector(const mapped_vector &other, const allocator_type &allocator) : mapped_vector(allocator) {
+            append_copies(other);
+        }
+
+        /**
+         *  Move constructor. Steals the storage of the other, including a borrowed
+         *  mapping.
+         *
+         *  @param other Another container to move the elements from.
+         */
+        mapped_vector(mapped_vector &&other) noexcept : mapped_vector(other._allocator) {
+            adopt(std::move(other));
+        }
+
+        /**
+         *  Constructs the container with the elements of the other using move semantics.
+         *  A borrowed mapping always changes owners, since it is not tied to either
+         *  allocator; owned storage changes owners only when the given allocator compares
+         *  equal to the other's, and the elements are moved one by one otherwise.
+         *
+         *  @param other     Another container to move the elements from.
+         *  @param allocator The user supplied allocator.
+         */
+        mapped_vector(mapped_vector &&other, const allocator_type &allocator) : mapped_vector(allocator) {
+            if (other.borrowed() || _allocator == other._allocator) {
+                adopt(std::move(other));
+            } else {
+                append_moves(std::move(other));
+            }
+        }
+
+        /**
+         *  Constructs the container with the contents of the initializer list.
+         *
+         *  @param initializer_list The initializer list to initialize the elements of the container with.
+         *  @param allocator        The user supplied allocator.
+         */
+        mapped_vector(std::initializer_list<value_type> initializer_list,
+                      const allocator_type &allocator = allocator_type())
+            : mapped_vector(initializer_list.begin(), initializer_list.end(), allocator) {
+        }
+
+        /**
+         *  Destructor. Releases the owned storage, or the reference to the borrowed
+         *  mapping.
+         */
+        ~mapped_vector() {
+            release();
+        }
+
+        /**
+         *  Copy assignment operator.
+         */
+        mapped_vector &operator=(const mapped_vector &other) {
+            if (this != &other) {
+                assign(other.begin(), other.end());
+            }
+            return *this;
+        }
+
+        /**
+         *  Move assignment operator.
+         */
+        mapped_vector &operator=(mapped_vector &&other) {
+            if (this != &other) {
+                release();
+                if (other.borrowed() || _allocator == other._allocator) {
+                    adopt(std::move(other));
+                } else {
+                    append_moves(std::move(other));
+                }
+            }
+            return *this;
+        }
+
+        /**
+         *  Replaces the contents with the elements from the initializer list.
+         */
+        mapped_vector &operator=(std::initializer_list<value_type> initializer_list) {
+            assign(initializer_list.begin(), initializer_list.end());
+            return *this;
+        }
+
+        /**
+         *  Replaces the contents with the copies of the given value.
+         *
+         *  @param count The number of elements.
+         *  @param value The value to initialize elements with.
+         */
+        void assign(size_type count, const_reference value) {
+            clear();
+            resize(count, value);
+        }
+
+        /**
+         *  Replaces the contents with copies of those in the range [first, last).
+         *
+         *  @param first The iterator that appoints the top of the range.
+         *  @param last  The iterator that appoints the last next of the range.
+         */
+        template <class InputIterator,
+                  class = typename std::enable_if<!std::is_integral<InputIterator>::value>::type>
+        void assign(InputIterator first, InputIterator last) {
+            clear();
+            while (first != last) {
+                push_back(*first);
+                ++first;
+            }
+        }
+
+        /**
+         *  Replaces the contents with the elements from the initializer list.
+         *
+         *  @param initializer_list The initializer list to copy the values from.
+         */
+        void assign(std::initializer_list<value_type> initializer_list) {
+            assign(initializer_list.begin(), initializer_list.end());
+        }
+
+        /**
+         *  Returns the associated allocator.
+         */
+        allocator_type get_allocator() const {
+            return _allocator;
+        }
+
+        /**
+         *  Gets the n-th element with bounds checking.
+         */
+        const_reference at(size_type n) const {
+            if (n >= _size) {
+                throw std::out_of_range("mapped_vector::at");
+            }
+            return _data[n];
+        }
+
+        /**
+         *  Gets the n-th element with bounds checking. Detaches from a borrowed
+         *  mapping, as the reference may be written through.
+         */
+        reference at(size_type n) {
+            if (n >= _size) {
+                throw std::out_of_range("mapped_vector::at");
+            }
+            detach();
+            return _data[n];
+        }
+
+        /**
+         *  Gets the n-th element. Detaches from a borrowed mapping.
+         */
+        reference operator[](size_type n) {
+            detach();
+            return _data[n];
+        }
+
+        /**
+         *  Gets the n-th element.
+         */
+        const_reference operator[](size_type n) const {
+            return _data[n];
+        }
+
+        /**
+         *  Gets the first element. Detaches from a borrowed mapping.
+         */
+        reference front() {
+            detach();
+            return _data[0];
+        }
+
+        /**
+         *  Gets the first element.
+         */
+        const_reference front() const {
+            return _data[0];
+        }
+
+        /**
+         *  Gets the last element. Detaches from a borrowed mapping.
+         */
+        reference back() {
+            detach();
+            return _data[_size - 1];
+        }
+
+        /**
+         *  Gets the last element.
+         */
+        const_reference back() const {
+            return _data[_size - 1];
+        }
+
+        /**
+         *  Gets the pointer to the underlying array. Detaches from a borrowed mapping.
+         */
+        pointer data() {
+            detach();
+            return _data;
+        }
+
+        /**
+         *  Gets the pointer to the underlying array.
+         */
+        const_pointer data() const noexcept {
+            return _data;
+        }
+
+        /**
+         *  Returns the iterator to the beginning. Detaches from a borrowed mapping.
+         */
+        iterator begin() {
+            detach();
+            return _data;
+        }
+
+        /**
+         *  Returns the iterator to the end. Detaches from a borrowed mapping.
+         */
+        iterator end() {
+            detach();
+            return _data + _size;
+        }
+
+        /**
+         *  Returns the iterator to the beginning.
+         */
+        const_iterator begin() const noexcept {
+            return _data;
+        }
+
+        /**
+         *  Returns the iterator to the end.
+         */
+        const_iterator end() const noexcept {
+            return _data + _size;
+        }
+
+        /**
+         *  Returns the iterator to the beginning.
+         */
+        const_iterator cbegin() const noexcept {
+            return begin();
+        }
+
+        /**
+         *  Returns the iterator to the end.
+         */
+        const_iterator cend() const noexcept {
+            return end();
+        }
+
+        /**
+         *  Checks whether the container is empty.
+         */
+        bool empty() const noexcept {
+            return _size == 0;
+        }
+
+        /**
+         *  Returns the number of elements.
+         */
+        size_type size() const noexcept {
+            return _size;
+        }
+
+        /**
+         *  Returns the max possible number of elements.
+         */
+        size_type max_size() const noexcept {
+            return std::allocator_traits<allocator_type>::max_size(_allocator);
+        }
+
+        /**
+         *  Reserves the storage for at least the given number of elements, detaching
+         *  from a borrowed mapping when growing past it.
+         *
+         *  @param new_cap The new capacity of the container.
+         */
+        void reserve(size_type new_cap) {
+            if (new_cap > _capacity) {
+                grow(new_cap);
+            }
+        }
+
+        /**
+         *  Returns the number of elements that can be held without reallocation.
+         */
+        size_type capacity() const noexcept {
+            return _capacity;
+        }
+
+        /**
+         *  Trims the owned storage to the current size. Borrowed elements are already
+         *  exact, so a mapped container is left untouched.
+         */
+        void shrink_to_fit() {
+            if (borrowed() || _size == _capacity) {
+                return;
+            }
+            if (_size == 0) {
+                release();
+            } else {
+                relocate(_size);
+            }
+        }
+
+        /**
+         *  Removes all elements. A borrowed mapping is released without copying it
+         *  first; otherwise the capacity is unchanged.
+         */
+        void clear() noexcept {
+            if (borrowed()) {
+                release();
+            } else {
+                destroy_all();
+                _size = 0;
+            }
+        }
+
+        /**
+         *  Inserts value before the given position.
+         *
+         *  @param pos   The position to insert before.
+         *  @param value The value to insert.
+         *
+         *  @return The iterator that appoints the inserted element.
+         */
+        iterator insert(const_iterator pos, const_reference value) {
+            auto index = static_cast<size_type>(pos - cbegin());
+            push_back(value);
+            std::rotate(begin() + index, end() - 1, end());
+            return begin() + index;
+        }
+
+        /**
+         *  Inserts value before the given position using move semantics.
+         *
+         *  @param pos   The position to insert before.
+         *  @param value The value to insert.
+         *
+         *  @return The iterator that appoints the inserted element.
+         */
+        iterator insert(const_iterator pos, value_type &&value) {
+            auto index = static_cast<size_type>(pos - cbegin());
+            push_back(std::move(value));
+            std::rotate(begin() + index, end() - 1, end());
+            return begin() + index;
+        }
+
+        /**
+         *  Inserts the given number of the copies of value before the given position.
+         *
+         *  @param pos   The position to insert before.
+         *  @param count The number of the copies to insert.
+         *  @param value The value to insert.
+         *
+         *  @return The iterator that appoints the first inserted element.
+         */
+        iterator insert(const_iterator pos, size_type count, const_reference value) {
+            auto index = static_cast<size_type>(pos - cbegin());
+            for (size_type i = 0; i < count; ++i) {
+                push_back(value);
+            }
+            std::rotate(begin() + index, end() - static_cast<difference_type>(count), end());
+            return begin() + index;
+        }
+
+        /**
+         *  Inserts the elements of the range [first, last) before the given position.
+         *
+         *  @param pos         The position to insert before.
+         *  @param first, last The range to copy the elements from.
+         *
+         *  @return The iterator that appoints the first inserted element.
+         */
+        template <class InputIterator,
+                  class = typename std::enable_if<!std::is_integral<InputIterator>::value>::type>
+        iterator insert(const_iterator pos, InputIterator first, InputIterator last) {
+            auto index = static_cast<size_type>(pos - cbegin());
+            auto old_size = _size;
+            while (first != last) {
+                push_back(*first);
+                ++first;
+            }
+            std::rotate(begin() + index, begin() + old_size, end());
+            return begin() + index;
+        }
+
+        /**
+         *  Inserts the elements of the initializer list before the given position.
+         *
+         *  @param pos              The position to insert before.
+         *  @param initializer_list The initializer list to copy the elements from.
+         *
+         *  @return The iterator that appoints the first inserted element.
+         */
+        iterator insert(const_iterator pos, std::initializer_list<value_type> initializer_list) {
+            return insert(pos, initializer_list.begin(), initializer_list.end());
+        }
+
+        /**
+         *  Constructs an element in place before the given position.
+         *
+         *  @param pos  The position to insert before.
+         *  @param args The arguments to forward to the constructor of the element.
+         *
+         *  @return The iterator that appoints the inserted element.
+         */
+        template <class... ArgTypes>
+        iterator emplace(const_iterator pos, ArgTypes &&... args) {
+            auto index = static_cast<size_type>(pos - cbegin());
+            emplace_back(std::forward<ArgTypes>(args)...);
+            std::rotate(begin() + index, end() - 1, end());
+            return begin() + index;
+        }
+
+        /**
+         *  Removes the element at the given position.
+         *
+         *  @param pos The position of the element to remove.
+         *
+         *  @return The iterator following the removed element.
+         */
+        iterator erase(const_iterator pos) {
+            auto index = static_cast<size_type>(pos - cbegin());
+            detach();
+            std::move(begin() + index + 1, end(), begin() + index);
+            pop_back();
+            return begin() + index;
+        }
+
+        /**
+         *  Removes the elements of the range [first, last).
+         *
+         *  @param first, last The range of the elements to remove.
+         *
+         *  @return The iterator following the last removed element.
+         */
+        iterator erase(const_iterator first, const_iterator last) {
+            auto index = static_cast<size_type>(first - cbegin());
+            auto count = static_cast<size_type>(last - first);
+            detach();
+            std::move(begin() + index + count, end(), begin() + index);
+            for (size_type i = 0; i < count; ++i) {
+                pop_back();
+            }
+            return begin() + index;
+        }
+
+        /**
+         *  Appends the given value.
+         *
+         *  @param value The value to append.
+         */
+        void push_back(const_reference value) {
+            if (_size == _capacity) {
+                value_type copied(value);
+                grow(_size + 1);
+                construct(_data + _size, std::move(copied));
+            } else {
+                construct(_data + _size, value);
+            }
+            ++_size;
+        }
+
+        /**
+         *  Appends the given value using move semantics.
+         *
+         *  @param value The value to append.
+         */
+        void push_back(value_type &&value) {
+            if (_size == _capacity) {
+                value_type moved(std::move(value));
+                grow(_size + 1);
+                construct(_data + _size, std::move(moved));
+            } else {
+                construct(_data + _size, std::move(value));
+            }
+            ++_size;
+        }
+
+        /**
+         *  Appends an element constructed in place.
+         *
+         *  @param args The arguments to forward to the constructor of the element.
+         */
+        template <class... ArgTypes>
+        void emplace_back(ArgTypes &&... args) {
+            if (_size == _capacity) {
+                grow(_size + 1);
+            }
+            construct(_data + _size, std::forward<ArgTypes>(args)...);
+            ++_size;
+        }
+
+        /**
+         *  Removes the last element. Detaches from a borrowed mapping.
+         */
+        void pop_back() {
+            detach();
+            --_size;
+            destroy(_data + _size);
+        }
+
+        /**
+         *  Resizes the container.
+         *  If the current size is less than the given count, the default-inserted instances of value_type are appended.
+         *
+         *  @param count The new size of the container.
+         */
+        void resize(size_type count) {
+            reserve(count);
+            while (_size > count) {
+                pop_back();
+            }
+            while (_size < count) {
+                emplace_back();
+            }
+        }
+
+        /**
+         *  Resizes the container.
+         *  If the current size is less than the given count, the copies of the given value are appended.
+         *
+         *  @param count The new size of the container.
+         *  @param value The value to initialize the new elements with.
+         */
+        void resize(size_type count, const_reference value) {
+            reserve(count);
+            while (_size > count) {
+                pop_back();
+            }
+            while (_size < count) {
+                push_back(value);
+            }
+        }
+
+        /**
+         *  Swaps the contents, including a borrowed mapping.
+         *
+         *  @param other The container to exchange the contents with.
+         */
+        void swap(mapped_vector &other) {
+            std::swap(_allocator, other._allocator);
+            std::swap(_data, other._data);
+            std::swap(_size, other._size);
+            std::swap(_capacity, other._capacity);
+            std::swap(_mapping, other._mapping);
+        }
+
+        /**
+         *  Compares the contents of two containers.
+         */
+        friend bool operator==(const mapped_vector &lhs, const mapped_vector &rhs) {
+            return lhs._size == rhs._size && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+        }
+
+        /**
+         *  Compares the contents of two containers.
+         */
+        friend bool operator!=(const mapped_vector &lhs, const mapped_vector &rhs) {
+            return !(lhs == rhs);
+        }
+
+        /**
+         *  Compares the contents of two containers.
+         */
+        friend bool operator<(const mapped_vector &lhs, const mapped_vector &rhs) {
+            return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+        }
+
+        /**
+         *  Compares the contents of two containers.
+         */
+        friend bool operator<=(const mapped_vector &lhs, const mapped_vector &rhs) {
+            return !(rhs < lhs);
+        }
+
+        /**
+         *  Compares the contents of two containers.
+         */
+        friend bool operator>(const mapped_vector &lhs, const mapped_vector &rhs) {
+            return rhs < lhs;
+        }
+
+        /**
+         *  Compares the contents of two containers.
+         */
+        friend bool operator>=(const mapped_vector &lhs, const mapped_vector &rhs) {
+            return !(lhs < rhs);
+        }
+
+    private:
+        bool borrowed() const noexcept {
+            return _mapping != nullptr;
+        }
+
+        template <class... ArgTypes>
+        void construct(pointer element, ArgTypes &&... args) {
+            std::allocator_traits<allocator_type>::construct(_allocator, element, std::forward<ArgTypes>(args)...);
+        }
+
+        void destroy(pointer element) {
+            std::allocator_traits<allocator_type>::destroy(_allocator, element);
+        }
+
+        void destroy_all() {
+            for (size_type i = 0; i < _size; ++i) {
+                destroy(_data + i);
+            }
+        }
+
+        /**
+         *  Returns to the empty state: destroys and deallocates owned elements, or
+         *  drops the reference to the borrowed mapping without touching them.
+         */
+        void release() noexcept {
+            if (borrowed()) {
+                _mapping.reset();
+            } else if (_data != nullptr) {
+                destroy_all();
+                std::allocator_traits<allocator_type>::deallocate(_allocator, _data, _capacity);
+            }
+            _data = nullptr;
+            _size = 0;
+            _capacity = 0;
+        }
+
+        /**
+         *  Copies the borrowed elements into owned storage and drops the mapping; the
+         *  lazy copy every writing operation funnels through. Owned storage is left
+         *  untouched.
+         */
+        void detach() {
+            if (borrowed()) {
+                relocate(_size > 0 ? _size : 1);
+            }
+        }
+
+        /**
+         *  Grows the storage so that at least min_capacity elements fit, at least
+         *  doubling so that repeated appends stay amortized constant.
+         */
+        void grow(size_type min_capacity) {
+            relocate(std::max(min_capacity, _capacity * 2));
+        }
+
+        /**
+         *  Moves the elements into owned storage of the given capacity, copying them
+         *  out of a borrowed mapping and dropping it.
+         */
+        void relocate(size_type new_capacity) {
+            auto destination = std::allocator_traits<allocator_type>::allocate(_allocator, new_capacity);
+            for (size_type i = 0; i < _size; ++i) {
+                construct(destination + i, std::move(_data[i]));
+            }
+            if (borrowed()) {
+                _mapping.reset();
+            } else if (_data != nullptr) {
+                destroy_all();
+                std::allocator_traits<allocator_type>::deallocate(_allocator, _data, _capacity);
+            }
+            _data = destination;
+            _capacity = new_capacity;
+        }
+
+        /**
+         *  Takes over the storage of the other, including a borrowed mapping.
+         *  Expects this container to be empty.
+         */
+        void adopt(mapped_vector &&other) noexcept {
+            _data = other._data;
+            _size = other._size;
+            _capacity = other._capacity;
+            _mapping = std::move(other._mapping);
+            other._data = nullptr;
+            other._size = 0;
+            other._capacity = 0;
+        }
+
+        /**
+         *  Appends the elements of the other using move semantics, then empties it.
+         *  Expects this container to be empty. Used instead of adopt when owned storage
+         *  cannot change owners because the allocators compare unequal.
+         */
+        void append_moves(mapped_vector &&other) {
+            if (other._size > 0) {
+                grow(other._size);
+                for (size_type i = 0; i < other._size; ++i) {
+                    construct(_data + i, std::move(other._data[i]));
+                    ++_size;
+                }
+            }
+            other.clear();
+        }
+
+        /**
+         *  Appends copies of the elements of the other.
+         *  Expects this container to be empty.
+         */
+        void append_copies(const mapped_vector &other) {
+            if (other._size == 0) {
+                return;
+            }
+            grow(other._size);
+            for (size_type i = 0; i < other._size; ++i) {
+                construct(_data + i, other._data[i]);
+                ++_size;
+            }
+        }
+
+        allocator_type _allocator;
+        pointer _data;
+        size_type _size;
+        size_type _capacity;
+        std::shared_ptr<const mapped_file> _mapping;
+    };
+
+    /**
+     *  The alias of copy_on_write_vector whose underlying container is
+     *  fe::mapped_vector, so that a saved snapshot can be adopted as the immutable
+     *  first version by moving in fe::mapped_vector::map's result, reloading a
+     *  checkpoint in O(page-fault) time and deferring the copy of the mapped elements
+     *  until the first mutation.
+     *
+     *  @tparam T         The type of the elements.
+     *  @tparam Allocator An allocator that is used to acquire memory once a version
+     *                    detaches from the mapping.
+     */
+    template <class T, class Allocator = std::allocator<T>>
+    using mapped_copy_on_write_vector = copy_on_write_vector<T, Allocator, mapped_vector<T, Allocator>>;
+}
+
+#endif /* defined(__ferrum__mapped_vector__) */
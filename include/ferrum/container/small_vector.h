@@ -0,0 +1,897 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Daisuke Itabashi (https://github.com/idaisuke/ferrum)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef __ferrum__small_vector__
+#define __ferrum__small_vector__
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "copy_on_write_vector.h"
+
+namespace fe {
+
+    /**
+     *  Represents a contiguous vector that stores up to N elements in an inline buffer
+     *  and only spills to allocator-acquired storage beyond that.
+     *  For the tiny element counts the inline buffer covers, construction and mutation
+     *  never touch the allocator, and the elements sit next to the bookkeeping fields,
+     *  so a scan touches a single allocation instead of chasing a data pointer.
+     *
+     *  This container is intended as the backing store of fe::copy_on_write_vector for
+     *  tiny hot containers, selectable through its Container template parameter: a
+     *  version then keeps its elements inside the shared allocation made by the
+     *  container, so copying a version of up to N elements allocates nothing beyond
+     *  the (recycled) version itself.
+     *
+     *  ~~~~~~~~~~
+     *  fe::small_copy_on_write_vector<int, 8> listeners;
+     *
+     *  // stays free of element heap allocations up to 8 elements.
+     *  listeners.push_back(999);
+     *  ~~~~~~~~~~
+     *
+     *  @tparam T         The type of the elements.
+     *  @tparam N         The number of elements the inline buffer holds.
+     *  @tparam Allocator An allocator that is used to acquire memory once the inline
+     *                    buffer is exceeded.
+     */
+    template <class T, std::size_t N, class Allocator = std::allocator<T>>
+    class small_vector {
+        static_assert(N > 0, "small_vector requires a non-zero inline capacity");
+
+    public:
+        /**
+         *  The type of the elements.
+         */
+        using value_type = T;
+
+        /**
+         *  The type of the allocator.
+         */
+        using allocator_type = Allocator;
+
+        /**
+         *  The unsigned integral type of the size of the container.
+         */
+        using size_type = std::size_t;
+
+        /**
+         *  The signed integral type of the distance of the iterators.
+         */
+        using difference_type = std::ptrdiff_t;
+
+        /**
+         *  The type of the reference of the elements.
+         */
+        using reference = value_type &;
+
+        /**
+         *  The type of the constant reference of the elements.
+         */
+        using const_reference = const value_type &;
+
+        /**
+         *  The type of the pointer of the elements.
+         */
+        using pointer = typename std::allocator_traits<allocator_type>::pointer;
+
+        /**
+         *  The type of the constant pointer of the elements.
+         */
+        using const_pointer = typename std::allocator_traits<allocator_type>::const_pointer;
+
+        /**
+         *  The type of the iterator, a raw element pointer.
+         */
+        using iterator = value_type *;
+
+        /**
+         *  The type of the constant iterator, a raw element pointer.
+         */
+        using const_iterator = const value_type *;
+
+        /**
+         *  The type of the reverse iterator.
+         */
+        using reverse_iterator = std::reverse_iterator<iterator>;
+
+        /**
+         *  The type of the constant reverse iterator.
+         */
+        using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+        /**
+         *  Default constructor. Constructs an empty container.
+         */
+        small_vector() noexcept : small_vector(allocator_type()) {
+        }
+
+        /**
+         *  Constructs an empty container.
+         *
+         *  @param allocator The user supplied allocator.
+         */
+        explicit small_vector(const allocator_type &allocator) noexcept
+            : _allocator(allocator), _data(inline_data()), _size(0), _capacity(N) {
+        }
+
+        /**
+         *  Constructs the container with the copies of elements with the given value.
+         *
+         *  @param count     The number of elements.
+         *  @param value     The value to initialize elements with.
+         *  @param allocator The user supplied allocator.
+         */
+        small_vector(size_type count, const_reference value, const allocator_type &allocator = allocator_type())
+            : small_vector(allocator) {
+            resize(count, value);
+        }
+
+        /**
+         *  Constructs the container with the given number of the default-inserted elements.
+         *
+         *  @param count The number of elements.
+         */
+        explicit small_vector(size_type count) : small_vector() {
+            resize(count);
+        }
+
+        /**
+         *  Constructs the container with the contents of the range [first, last).
+         *
+         *  @param first, last The range to copy the elements from.
+         *  @param allocator   The user supplied allocator.
+         */
+        template <class InputIterator,
+                  class = typename std::enable_if<!std::is_integral<InputIterator>::value>::type>
+        small_vector(InputIterator first, InputIterator last, const allocator_type &allocator = allocator_type())
+            : small_vector(allocator) {
+            while (first != last) {
+                push_back(*first);
+                ++first;
+            }
+        }
+
+        /**
+         *  Copy constructor.
+         *
+         *  @param other Another container to copy the elements from.
+         */
+        small_vector(const small_vector &other) : small_vector(other._allocator) {
+            append_copies(other);
+        }
+
+        /**
+         *  Constructs the container with the copies of the elements of the other.
+         *
+         *  @param other     Another container to copy the elements from.
+         *  @param allocator The user supplied allocator.
+         */
+        small_vector(const small_vector &other, const allocator_type &allocator) : small_vector(allocator) {
+            append_copies(other);
+        }
+
+        /**
+         *  Move constructor. Steals the spilled storage of the other when there is one,
+         *  and moves the elements one by one while they are still inline.
+         *
+         *  @param other Another container to move the elements from.
+         */
+        small_vector(small_vector &&other) : small_vector(other._allocator) {
+            adopt(std::move(other));
+        }
+
+        /**
+         *  Constructs the container with the elements of the other using move semantics.
+         *  When the given allocator compares unequal to the other's, the spilled storage
+         *  cannot change owners and the elements are moved one by one instead.
+         *
+         *  @param other     Another container to move the elements from.
+         *  @param allocator The user supplied allocator.
+         */
+        small_vector(small_vector &&other, const allocator_type &allocator) : small_vector(allocator) {
+            if (_allocator == other._allocator) {
+                adopt(std::move(other));
+            } else {
+                append_moves(std::move(other));
+            }
+        }
+
+        /**
+         *  Constructs the container with the contents of the initializer list.
+         *
+         *  @param initializer_list The initializer list to initialize the elements of the container with.
+         *  @param allocator        The user supplied allocator.
+         */
+        small_vector(std::initializer_list<value_type> initializer_list,
+                     const allocator_type &allocator = allocator_type())
+            : small_vector(initializer_list.begin(), initializer_list.end(), allocator) {
+        }
+
+        /**
+         *  Destructor.
+         */
+        ~small_vector() {
+            destroy_all();
+            release_storage();
+        }
+
+        /**
+         *  Copy assignment operator.
+         */
+        small_vector &operator=(const small_vector &other) {
+            if (this != &other) {
+                assign(other.begin(), other.end());
+            }
+            return *this;
+        }
+
+        /**
+         *  Move assignment operator.
+         */
+        small_vector &operator=(small_vector &&other) {
+            if (this != &other) {
+                destroy_all();
+                release_storage();
+                _data = inline_data();
+                _capacity = N;
+                _size = 0;
+                if (_allocator == other._allocator) {
+                    adopt(std::move(other));
+                } else {
+                    append_moves(std::move(other));
+                }
+            }
+            return *this;
+        }
+
+        /**
+         *  Replaces the contents with the elements from the initializer list.
+         */
+        small_vector &operator=(std::initializer_list<value_type> initializer_list) {
+            assign(initializer_list.begin(), initializer_list.end());
+            return *this;
+        }
+
+        /**
+         *  Replaces the contents with the copies of the given value.
+         *
+         *  @param count The number of elements.
+         *  @param value The value to initialize elements with.
+         */
+        void assign(size_type count, const_reference value) {
+            clear();
+            resize(count, value);
+        }
+
+        /**
+         *  Replaces the contents with copies of those in the range [first, last).
+         *
+         *  @param first The iterator that appoints the top of the range.
+         *  @param last  The iterator that appoints the last next of the range.
+         */
+        template <class InputIterator,
+                  class = typename std::enable_if<!std::is_integral<InputIterator>::value>::type>
+        void assign(InputIterator first, InputIterator last) {
+            clear();
+            while (first != last) {
+                push_back(*first);
+                ++first;
+            }
+        }
+
+        /**
+         *  Replaces the contents with the elements from the initializer list.
+         *
+         *  @param initializer_list The initializer list to copy the values from.
+         */
+        void assign(std::initializer_list<value_type> initializer_list) {
+            assign(initializer_list.begin(), initializer_list.end());
+        }
+
+        /**
+         *  Returns the associated allocator.
+         */
+        allocator_type get_allocator() const {
+            return _allocator;
+        }
+
+        /**
+         *  Gets the n-th element with bounds checking.
+         */
+        const_reference at(size_type n) const {
+            if (n >= _size) {
+                throw std::out_of_range("small_vector::at");
+            }
+            return _data[n];
+        }
+
+        /**
+         *  Gets the n-th element with bounds checking.
+         */
+        reference at(size_type n) {
+            if (n >= _size) {
+                throw std::out_of_range("small_vector::at");
+            }
+            return _data[n];
+        }
+
+        /**
+         *  Gets the n-th element.
+         */
+        reference operator[](size_type n) {
+            return _data[n];
+        }
+
+        /**
+         *  Gets the n-th element.
+         */
+        const_reference operator[](size_type n) const {
+            return _data[n];
+        }
+
+        /**
+         *  Gets the first element.
+         */
+        reference front() {
+            return _data[0];
+        }
+
+        /**
+         *  Gets the first element.
+         */
+        const_reference front() const {
+            return _data[0];
+        }
+
+        /**
+         *  Gets the last element.
+         */
+        reference back() {
+            return _data[_size - 1];
+        }
+
+        /**
+         *  Gets the last element.
+         */
+        const_reference back() const {
+            return _data[_size - 1];
+        }
+
+        /**
+         *  Gets the pointer to the underlying array.
+         */
+        pointer data() noexcept {
+            return _data;
+        }
+
+        /**
+         *  Gets the pointer to the underlying array.
+         */
+        const_pointer data() const noexcept {
+            return _data;
+        }
+
+        /**
+         *  Returns the iterator to the beginning.
+         */
+        iterator begin() noexcept {
+            return _data;
+        }
+
+        /**
+         *  Returns the iterator to the end.
+         */
+        iterator end() noexcept {
+            return _data + _size;
+        }
+
+        /**
+         *  Returns the iterator to the beginning.
+         */
+        const_iterator begin() const noexcept {
+            return _data;
+        }
+
+        /**
+         *  Returns the iterator to the end.
+         */
+        const_iterator end() const noexcept {
+            return _data + _size;
+        }
+
+        /**
+         *  Returns the iterator to the beginning.
+         */
+        const_iterator cbegin() const noexcept {
+            return begin();
+        }
+
+        /**
+         *  Returns the iterator to the end.
+         */
+        const_iterator cend() const noexcept {
+            return end();
+        }
+
+        /**
+         *  Checks whether the container is empty.
+         */
+        bool empty() const noexcept {
+            return _size == 0;
+        }
+
+        /**
+         *  Returns the number of elements.
+         */
+        size_type size() const noexcept {
+            return _size;
+        }
+
+        /**
+         *  Returns the max possible number of elements.
+         */
+        size_type max_size() const noexcept {
+            return std::allocator_traits<allocator_type>::max_size(_allocator);
+        }
+
+        /**
+         *  Reserves the storage for at least the given number of elements.
+         *
+         *  @param new_cap The new capacity of the container.
+         */
+        void reserve(size_type new_cap) {
+            if (new_cap > _capacity) {
+                grow(new_cap);
+            }
+        }
+
+        /**
+         *  Returns the number of elements that can be held without reallocation; never
+         *  less than the inline capacity N.
+         */
+        size_type capacity() const noexcept {
+            return _capacity;
+        }
+
+        /**
+         *  Moves the elements back into the inline buffer when they fit again, releasing
+         *  the spilled storage; otherwise trims the spilled storage to the current size.
+         */
+        void shrink_to_fit() {
+            if (!spilled() || _size == _capacity) {
+                return;
+            }
+            relocate(_size <= N ? N : _size);
+        }
+
+        /**
+         *  Removes all elements. The capacity is unchanged.
+         */
+        void clear() noexcept {
+            destroy_all();
+            _size = 0;
+        }
+
+        /**
+         *  Inserts value before the given position.
+         *
+         *  @param pos   The position to insert before.
+         *  @param value The value to insert.
+         *
+         *  @return The iterator that appoints the inserted element.
+         */
+        iterator insert(const_iterator pos, const_reference value) {
+            auto index = static_cast<size_type>(pos - begin());
+            push_back(value);
+            std::rotate(begin() + index, end() - 1, end());
+            return begin() + index;
+        }
+
+        /**
+         *  Inserts value before the given position using move semantics.
+         *
+         *  @param pos   The position to insert before.
+         *  @param value The value to insert.
+         *
+         *  @return The iterator that appoints the inserted element.
+         */
+        iterator insert(const_iterator pos, value_type &&value) {
+            auto index = static_cast<size_type>(pos - begin());
+            push_back(std::move(value));
+            std::rotate(begin() + index, end() - 1, end());
+            return begin() + index;
+        }
+
+        /**
+         *  Inserts the given number of the copies of value before the given position.
+         *
+         *  @param pos   The position to insert before.
+         *  @param count The number of the copies to insert.
+         *  @param value The value to insert.
+         *
+         *  @return The iterator that appoints the first inserted element.
+         */
+        iterator insert(const_iterator pos, size_type count, const_reference value) {
+            auto index = static_cast<size_type>(pos - begin());
+            for (size_type i = 0; i < count; ++i) {
+                push_back(value);
+            }
+            std::rotate(begin() + index, end() - static_cast<difference_type>(count), end());
+            return begin() + index;
+        }
+
+        /**
+         *  Inserts the elements of the range [first, last) before the given position.
+         *
+         *  @param pos         The position to insert before.
+         *  @param first, last The range to copy the elements from.
+         *
+         *  @return The iterator that appoints the first inserted element.
+         */
+        template <class InputIterator,
+                  class = typename std::enable_if<!std::is_integral<InputIterator>::value>::type>
+        iterator insert(const_iterator pos, InputIterator first, InputIterator last) {
+            auto index = static_cast<size_type>(pos - begin());
+            auto old_size = _size;
+            while (first != last) {
+                push_back(*first);
+                ++first;
+            }
+            std::rotate(begin() + index, begin() + old_size, end());
+            return begin() + index;
+        }
+
+        /**
+         *  Inserts the elements of the initializer list before the given position.
+         *
+         *  @param pos              The position to insert before.
+         *  @param initializer_list The initializer list to copy the elements from.
+         *
+         *  @return The iterator that appoints the first inserted element.
+         */
+        iterator insert(const_iterator pos, std::initializer_list<value_type> initializer_list) {
+            return insert(pos, initializer_list.begin(), initializer_list.end());
+        }
+
+        /**
+         *  Constructs an element in place before the given position.
+         *
+         *  @param pos  The position to insert before.
+         *  @param args The arguments to forward to the constructor of the element.
+         *
+         *  @return The iterator that appoints the inserted element.
+         */
+        template <class... ArgTypes>
+        iterator emplace(const_iterator pos, ArgTypes &&... args) {
+            auto index = static_cast<size_type>(pos - begin());
+            emplace_back(std::forward<ArgTypes>(args)...);
+            std::rotate(begin() + index, end() - 1, end());
+            return begin() + index;
+        }
+
+        /**
+         *  Removes the element at the given position.
+         *
+         *  @param pos The position of the element to remove.
+         *
+         *  @return The iterator following the removed element.
+         */
+        iterator erase(const_iterator pos) {
+            auto index = static_cast<size_type>(pos - begin());
+            std::move(begin() + index + 1, end(), begin() + index);
+            pop_back();
+            return begin() + index;
+        }
+
+        /**
+         *  Removes the elements of the range [first, last).
+         *
+         *  @param first, last The range of the elements to remove.
+         *
+         *  @return The iterator following the last removed element.
+         */
+        iterator erase(const_iterator first, const_iterator last) {
+            auto index = static_cast<size_type>(first - begin());
+            auto count = static_cast<size_type>(last - first);
+            std::move(begin() + index + count, end(), begin() + index);
+            for (size_type i = 0; i < count; ++i) {
+                pop_back();
+            }
+            return begin() + index;
+        }
+
+        /**
+         *  Appends the given value.
+         *
+         *  @param value The value to append.
+         */
+        void push_back(const_reference value) {
+            if (_size == _capacity) {
+                value_type copied(value);
+                grow(_size + 1);
+                construct(_data + _size, std::move(copied));
+            } else {
+                construct(_data + _size, value);
+            }
+            ++_size;
+        }
+
+        /**
+         *  Appends the given value using move semantics.
+         *
+         *  @param value The value to append.
+         */
+        void push_back(value_type &&value) {
+            if (_size == _capacity) {
+                value_type moved(std::move(value));
+                grow(_size + 1);
+                construct(_data + _size, std::move(moved));
+            } else {
+                construct(_data + _size, std::move(value));
+            }
+            ++_size;
+        }
+
+        /**
+         *  Appends an element constructed in place.
+         *
+         *  @param args The arguments to forward to the constructor of the element.
+         */
+        template <class... ArgTypes>
+        void emplace_back(ArgTypes &&... args) {
+            if (_size == _capacity) {
+                grow(_size + 1);
+            }
+            construct(_data + _size, std::forward<ArgTypes>(args)...);
+            ++_size;
+        }
+
+        /**
+         *  Removes the last element.
+         */
+        void pop_back() {
+            --_size;
+            destroy(_data + _size);
+        }
+
+        /**
+         *  Resizes the container.
+         *  If the current size is less than the given count, the default-inserted instances of value_type are appended.
+         *
+         *  @param count The new size of the container.
+         */
+        void resize(size_type count) {
+            reserve(count);
+            while (_size > count) {
+                pop_back();
+            }
+            while (_size < count) {
+                emplace_back();
+            }
+        }
+
+        /**
+         *  Resizes the container.
+         *  If the current size is less than the given count, the copies of the given value are appended.
+         *
+         *  @param count The new size of the container.
+         *  @param value The value to initialize the new elements with.
+         */
+        void resize(size_type count, const_reference value) {
+            reserve(count);
+            while (_size > count) {
+                pop_back();
+            }
+            while (_size < count) {
+                push_back(value);
+            }
+        }
+
+        /**
+         *  Swaps the contents. Because either side may hold its elements inline, this is
+         *  a three-way move rather than a pointer swap.
+         *
+         *  @param other The container to exchange the contents with.
+         */
+        void swap(small_vector &other) {
+            small_vector temporary(std::move(*this));
+            *this = std::move(other);
+            other = std::move(temporary);
+        }
+
+        /**
+         *  Compares the contents of two containers.
+         */
+        friend bool operator==(const small_vector &lhs, const small_vector &rhs) {
+            return lhs._size == rhs._size && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+        }
+
+        /**
+         *  Compares the contents of two containers.
+         */
+        friend bool operator!=(const small_vector &lhs, const small_vector &rhs) {
+            return !(lhs == rhs);
+        }
+
+        /**
+         *  Compares the contents of two containers.
+         */
+        friend bool operator<(const small_vector &lhs, const small_vector &rhs) {
+            return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+        }
+
+        /**
+         *  Compares the contents of two containers.
+         */
+        friend bool operator<=(const small_vector &lhs, const small_vector &rhs) {
+            return !(rhs < lhs);
+        }
+
+        /**
+         *  Compares the contents of two containers.
+         */
+        friend bool operator>(const small_vector &lhs, const small_vector &rhs) {
+            return rhs < lhs;
+        }
+
+        /**
+         *  Compares the contents of two containers.
+         */
+        friend bool operator>=(const small_vector &lhs, const small_vector &rhs) {
+            return !(lhs < rhs);
+        }
+
+    private:
+        pointer inline_data() noexcept {
+            return reinterpret_cast<pointer>(_inline_storage);
+        }
+
+        bool spilled() const noexcept {
+            return _capacity > N;
+        }
+
+        template <class... ArgTypes>
+        void construct(pointer element, ArgTypes &&... args) {
+            std::allocator_traits<allocator_type>::construct(_allocator, element, std::forward<ArgTypes>(args)...);
+        }
+
+        void destroy(pointer element) {
+            std::allocator_traits<allocator_type>::destroy(_allocator, element);
+        }
+
+        void destroy_all() {
+            for (size_type i = 0; i < _size; ++i) {
+                destroy(_data + i);
+            }
+        }
+
+        void release_storage() {
+            if (spilled()) {
+                std::allocator_traits<allocator_type>::deallocate(_allocator, _data, _capacity);
+            }
+        }
+
+        /**
+         *  Grows the storage so that at least min_capacity elements fit, at least
+         *  doubling so that repeated appends stay amortized constant.
+         */
+        void grow(size_type min_capacity) {
+            relocate(std::max(min_capacity, _capacity * 2));
+        }
+
+        /**
+         *  Moves the elements into storage of the given capacity: the inline buffer when
+         *  the capacity is N, spilled storage otherwise.
+         */
+        void relocate(size_type new_capacity) {
+            auto destination =
+                new_capacity <= N ? inline_data()
+                                  : std::allocator_traits<allocator_type>::allocate(_allocator, new_capacity);
+            for (size_type i = 0; i < _size; ++i) {
+                std::allocator_traits<allocator_type>::construct(_allocator, destination + i, std::move(_data[i]));
+                destroy(_data + i);
+            }
+            release_storage();
+            _data = destination;
+            _capacity = new_capacity <= N ? N : new_capacity;
+        }
+
+        /**
+         *  Takes over the contents of the other: steals the spilled storage when there is
+         *  one, and moves the elements one by one while they are still inline.
+         *  Expects this container to be empty with inline storage.
+         */
+        void adopt(small_vector &&other) {
+            if (other.spilled()) {
+                _data = other._data;
+                _size = other._size;
+                _capacity = other._capacity;
+                other._data = other.inline_data();
+                other._size = 0;
+                other._capacity = N;
+            } else {
+                _size = other._size;
+                for (size_type i = 0; i < _size; ++i) {
+                    construct(_data + i, std::move(other._data[i]));
+                }
+                other.clear();
+            }
+        }
+
+        /**
+         *  Appends the elements of the other using move semantics, then empties it.
+         *  Expects this container to be empty. Used instead of adopt when the storage
+         *  itself cannot change owners because the allocators compare unequal.
+         */
+        void append_moves(small_vector &&other) {
+            reserve(other._size);
+            for (size_type i = 0; i < other._size; ++i) {
+                construct(_data + i, std::move(other._data[i]));
+                ++_size;
+            }
+            other.clear();
+        }
+
+        /**
+         *  Appends copies of the elements of the other.
+         *  Expects this container to be empty.
+         */
+        void append_copies(const small_vector &other) {
+            reserve(other._size);
+            for (size_type i = 0; i < other._size; ++i) {
+                construct(_data + i, other._data[i]);
+                ++_size;
+            }
+        }
+
+        typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type _inline_storage[N];
+        allocator_type _allocator;
+        pointer _data;
+        size_type _size;
+        size_type _capacity;
+    };
+
+    /**
+     *  The alias of copy_on_write_vector whose underlying container is fe::small_vector,
+     *  so that a version of up to N elements keeps its elements inside the shared
+     *  allocation of the version itself: tiny containers stop paying a separate element
+     *  heap allocation per construction and per copied version, and a snapshot read is a
+     *  single indirection.
+     *
+     *  @tparam T         The type of the elements.
+     *  @tparam N         The number of elements stored inline in one version.
+     *  @tparam Allocator An allocator that is used to acquire memory once the inline
+     *                    buffer is exceeded.
+     */
+    template <class T, std::size_t N = 8, class Allocator = std::allocator<T>>
+    using small_copy_on_write_vector = copy_on_write_vector<T, Allocator, small_vector<T, N, Allocator>>;
+}
+
+#endif /* defined(__ferrum__small_vector__) */
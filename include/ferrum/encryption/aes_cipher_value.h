@@ -25,14 +25,22 @@
 
 #include <algorithm>
 #include <array>
+#include <cstddef>
 #include <functional>
 #include <iostream>
 #include <limits>
+#include <memory>
 #include <random>
 
 #include <openssl/evp.h>
 
+#if defined(__AES__)
+#include <wmmintrin.h>
+#endif
+
+#include "../stats.h"
 #include "cipher_value.h"
+#include "splitmix64.h"
 
 namespace fe {
     template <class T>
@@ -61,13 +69,19 @@ namespace fe {
     private:
         aes_cipher_value_random_engine_holder() = delete;
 
-        static std::random_device::result_type get_seed() {
+        static splitmix64::result_type get_seed() {
             std::random_device gen;
-            return gen();
+            return (static_cast<splitmix64::result_type>(gen()) << 32) | gen();
         }
 
-        static std::mt19937 &get() {
-            static std::mt19937 engine(get_seed());
+        /**
+         *  Returns the calling thread's key generation engine. One engine per thread
+         *  keeps concurrent cipher construction race-free and scalable, where the
+         *  previous single shared engine was both a data race and a serialization
+         *  point.
+         */
+        static splitmix64 &get() {
+            static thread_local splitmix64 engine(get_seed());
             return engine;
         }
 
@@ -114,47 +128,320 @@ namespace fe {
         aes_cipher &operator=(aes_cipher &&other) noexcept = default;
 
         encrypted_type encrypt(const value_type &unencrypted) const {
-            EVP_CIPHER_CTX context;
-            EVP_EncryptInit(&context, EVP_aes_128_ecb(), _key.data(), nullptr);
+            global_cipher_stats().record_encrypt(1);
 
             converter in;
             in.value = unencrypted;
 
             encrypted_type out;
 
+#if defined(__AES__)
+            auto block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in.bytes.data()));
+            block = _mm_xor_si128(block, _encrypt_round_keys[0]);
+            for (int round = 1; round < 10; ++round) {
+                block = _mm_aesenc_si128(block, _encrypt_round_keys[round]);
+            }
+            block = _mm_aesenclast_si128(block, _encrypt_round_keys[10]);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out.data()), block);
+#else
             int len;
-            EVP_EncryptUpdate(&context, out.data(), &len, in.bytes.data(), static_cast<int>(in.bytes.size()));
+            EVP_EncryptUpdate(_encrypt_context.get(), out.data(), &len, in.bytes.data(),
+                              static_cast<int>(in.bytes.size()));
+#endif
 
             return out;
         }
 
         value_type decrypt(const encrypted_type &encrypted) const {
-            EVP_CIPHER_CTX context;
-            EVP_DecryptInit(&context, EVP_aes_128_ecb(), _key.data(), nullptr);
+            global_cipher_stats().record_decrypt(1);
 
             converter out;
 
+#if defined(__AES__)
+            auto block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(encrypted.data()));
+            block = _mm_xor_si128(block, _decrypt_round_keys[0]);
+            for (int round = 1; round < 10; ++round) {
+                block = _mm_aesdec_si128(block, _decrypt_round_keys[round]);
+            }
+            block = _mm_aesdeclast_si128(block, _decrypt_round_keys[10]);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out.bytes.data()), block);
+#else
             int len;
-            EVP_DecryptUpdate(&context, out.bytes.data(), &len, encrypted.data(), static_cast<int>(encrypted.size()));
+            EVP_DecryptUpdate(_decrypt_context.get(), out.bytes.data(), &len, encrypted.data(),
+                              static_cast<int>(encrypted.size()));
+#endif
 
             return out.value;
         }
 
+        /**
+         *  Encrypts block_count consecutive 16 byte blocks from in to out in one pass
+         *  under this cipher's key. Backs fe::cipher_array, which packs several values
+         *  into whole blocks so that one call covers them all instead of one EVP round
+         *  trip per value.
+         */
+        void encrypt_blocks(const unsigned char *in, std::size_t block_count, unsigned char *out) const {
+            global_cipher_stats().record_encrypt(block_count);
+#if defined(__AES__)
+            for (std::size_t i = 0; i < block_count; ++i) {
+                auto block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i * 16));
+                block = _mm_xor_si128(block, _encrypt_round_keys[0]);
+                for (int round = 1; round < 10; ++round) {
+                    block = _mm_aesenc_si128(block, _encrypt_round_keys[round]);
+                }
+                block = _mm_aesenclast_si128(block, _encrypt_round_keys[10]);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i * 16), block);
+            }
+#else
+            int len;
+            EVP_EncryptUpdate(_encrypt_context.get(), out, &len, in, static_cast<int>(block_count * 16));
+#endif
+        }
+
+        /**
+         *  Decrypts block_count consecutive 16 byte blocks from in to out in one pass
+         *  under this cipher's key.
+         */
+        void decrypt_blocks(const unsigned char *in, std::size_t block_count, unsigned char *out) const {
+            global_cipher_stats().record_decrypt(block_count);
+#if defined(__AES__)
+            for (std::size_t i = 0; i < block_count; ++i) {
+                auto block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i * 16));
+                block = _mm_xor_si128(block, _decrypt_round_keys[0]);
+                for (int round = 1; round < 10; ++round) {
+                    block = _mm_aesdec_si128(block, _decrypt_round_keys[round]);
+                }
+                block = _mm_aesdeclast_si128(block, _decrypt_round_keys[10]);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i * 16), block);
+            }
+#else
+            int len;
+            EVP_DecryptUpdate(_decrypt_context.get(), out, &len, in, static_cast<int>(block_count * 16));
+#endif
+        }
+
     private:
+#if !defined(__AES__)
+        struct context_deleter {
+            void operator()(EVP_CIPHER_CTX *context) const {
+                EVP_CIPHER_CTX_free(context);
+            }
+        };
+#endif
+
         void init() {
             std::uniform_int_distribution<unsigned char> dist(std::numeric_limits<unsigned char>::min(),
                                                               std::numeric_limits<unsigned char>::max());
             auto rand = std::bind(dist, std::ref(aes_cipher_value_random_engine_holder::get()));
             std::generate(_key.begin(), _key.end(), rand);
+            derive_key_schedule();
         }
 
+        void derive_key_schedule() {
+#if defined(__AES__)
+            // The key schedule is expanded once here with AES-NI and each block is then
+            // encrypted and decrypted directly with the aesenc/aesdec instructions,
+            // bypassing the EVP streaming interface entirely for the single-block ECB
+            // workload of this class.
+            _encrypt_round_keys[0] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(_key.data()));
+            _encrypt_round_keys[1] = expand(_encrypt_round_keys[0], _mm_aeskeygenassist_si128(_encrypt_round_keys[0], 0x01));
+            _encrypt_round_keys[2] = expand(_encrypt_round_keys[1], _mm_aeskeygenassist_si128(_encrypt_round_keys[1], 0x02));
+            _encrypt_round_keys[3] = expand(_encrypt_round_keys[2], _mm_aeskeygenassist_si128(_encrypt_round_keys[2], 0x04));
+            _encrypt_round_keys[4] = expand(_encrypt_round_keys[3], _mm_aeskeygenassist_si128(_encrypt_round_keys[3], 0x08));
+            _encrypt_round_keys[5] = expand(_encrypt_round_keys[4], _mm_aeskeygenassist_si128(_encrypt_round_keys[4], 0x10));
+            _encrypt_round_keys[6] = expand(_encrypt_round_keys[5], _mm_aeskeygenassist_si128(_encrypt_round_keys[5], 0x20));
+            _encrypt_round_keys[7] = expand(_encrypt_round_keys[6], _mm_aeskeygenassist_si128(_encrypt_round_keys[6], 0x40));
+            _encrypt_round_keys[8] = expand(_encrypt_round_keys[7], _mm_aeskeygenassist_si128(_encrypt_round_keys[7], 0x80));
+            _encrypt_round_keys[9] = expand(_encrypt_round_keys[8], _mm_aeskeygenassist_si128(_encrypt_round_keys[8], 0x1b));
+            _encrypt_round_keys[10] = expand(_encrypt_round_keys[9], _mm_aeskeygenassist_si128(_encrypt_round_keys[9], 0x36));
+
+            _decrypt_round_keys[0] = _encrypt_round_keys[10];
+            for (int round = 1; round < 10; ++round) {
+                _decrypt_round_keys[round] = _mm_aesimc_si128(_encrypt_round_keys[10 - round]);
+            }
+            _decrypt_round_keys[10] = _encrypt_round_keys[0];
+#else
+            // The AES key schedule is expanded once here and the contexts are reused for
+            // every encrypt and decrypt, instead of re-keying a fresh context per block.
+            // In ECB mode each block is independent, so a reused context with padding
+            // disabled behaves identically to a freshly initialized one.
+            _encrypt_context.reset(EVP_CIPHER_CTX_new());
+            EVP_EncryptInit(_encrypt_context.get(), EVP_aes_128_ecb(), _key.data(), nullptr);
+            EVP_CIPHER_CTX_set_padding(_encrypt_context.get(), 0);
+
+            _decrypt_context.reset(EVP_CIPHER_CTX_new());
+            EVP_DecryptInit(_decrypt_context.get(), EVP_aes_128_ecb(), _key.data(), nullptr);
+            EVP_CIPHER_CTX_set_padding(_decrypt_context.get(), 0);
+#endif
+        }
+
+#if defined(__AES__)
+        static __m128i expand(__m128i round_key, __m128i keygen) {
+            keygen = _mm_shuffle_epi32(keygen, _MM_SHUFFLE(3, 3, 3, 3));
+            round_key = _mm_xor_si128(round_key, _mm_slli_si128(round_key, 4));
+            round_key = _mm_xor_si128(round_key, _mm_slli_si128(round_key, 4));
+            round_key = _mm_xor_si128(round_key, _mm_slli_si128(round_key, 4));
+            return _mm_xor_si128(round_key, keygen);
+        }
+#endif
+
         union converter {
             value_type value;
             encrypted_type bytes;
         };
 
         encrypted_type _key;
+#if defined(__AES__)
+        __m128i _encrypt_round_keys[11];
+        __m128i _decrypt_round_keys[11];
+#else
+        std::unique_ptr<EVP_CIPHER_CTX, context_deleter> _encrypt_context;
+        std::unique_ptr<EVP_CIPHER_CTX, context_deleter> _decrypt_context;
+#endif
+
+    protected:
+        struct uninitialized_key_tag {};
+
+        /**
+         *  Constructs the cipher without generating a key or expanding a schedule; for
+         *  the key-preserving policy classes, which copy the key material afterwards.
+         */
+        explicit aes_cipher(uninitialized_key_tag) {
+        }
+
+        /**
+         *  Copies the key of the other instead of re-rolling it and expands the key
+         *  schedule for it; for the key-preserving policy classes (see
+         *  fe::key_preserving_aes_cipher).
+         */
+        void copy_key_from(const aes_cipher &other) {
+            _key = other._key;
+            derive_key_schedule();
+        }
     };
+
+    /**
+     *  Represents an aes cipher whose key is shared by every instance for the same value
+     *  type, generated and expanded once per process. The cipher itself is empty, so a
+     *  cipher_value using it carries no per-instance key schedule or context and shrinks
+     *  to just its 16 byte block. Use fe::aes_cipher instead when every value must have
+     *  its own key. With the EVP backend the shared contexts are mutated per call, so
+     *  concurrent access from several threads needs external synchronization; the AES-NI
+     *  backend is stateless per call and safe to share.
+     *
+     *  @tparam T The type of the unencrypted value.
+     */
+    template <class T>
+    class shared_aes_cipher {
+    public:
+        using value_type = T;
+        using encrypted_type = typename aes_cipher<T>::encrypted_type;
+
+        /**
+         *  Every instance shares one process-wide key, so copies trivially decrypt what
+         *  the original encrypted (see fe::preserves_key_on_copy).
+         */
+        using key_preserving_copy = std::true_type;
+
+        encrypted_type encrypt(const value_type &unencrypted) const {
+            return key_cipher().encrypt(unencrypted);
+        }
+
+        value_type decrypt(const encrypted_type &encrypted) const {
+            return key_cipher().decrypt(encrypted);
+        }
+
+        void encrypt_blocks(const unsigned char *in, std::size_t block_count, unsigned char *out) const {
+            key_cipher().encrypt_blocks(in, block_count, out);
+        }
+
+        void decrypt_blocks(const unsigned char *in, std::size_t block_count, unsigned char *out) const {
+            key_cipher().decrypt_blocks(in, block_count, out);
+        }
+
+    private:
+        static const aes_cipher<T> &key_cipher() {
+            static const aes_cipher<T> cipher;
+            return cipher;
+        }
+    };
+
+    /**
+     *  The Alias of cipher_value using the aes_128_ecb algorithm with a process-wide
+     *  shared key per value type.
+     *
+     *  @tparam T The type of the unencrypted value.
+     */
+    template <class T>
+    using shared_aes_cipher_value = cipher_value<T, shared_aes_cipher>;
+
+    /**
+     *  Represents an aes cipher with its own key per instance, like fe::aes_cipher, but
+     *  whose copies keep the key instead of re-rolling one. Copying a cipher_value using
+     *  this policy copies the 16 byte block bitwise and expands the key schedule once,
+     *  instead of a decrypt plus re-encrypt round trip. The trade-off is that a value and
+     *  all of its copies stay under one key for their whole lifetime; clone_rekeyed()
+     *  hands out a freshly keyed cipher where that is not wanted.
+     *
+     *  @tparam T The type of the unencrypted value.
+     */
+    template <class T>
+    class key_preserving_aes_cipher : public aes_cipher<T> {
+    public:
+        /**
+         *  Copies preserve the key (see fe::preserves_key_on_copy).
+         */
+        using key_preserving_copy = std::true_type;
+
+        /**
+         *  Default constructor. Generates a fresh key like fe::aes_cipher.
+         */
+        key_preserving_aes_cipher() = default;
+
+        /**
+         *  Copy constructor. Copies the key material of the other.
+         */
+        key_preserving_aes_cipher(const key_preserving_aes_cipher &other)
+            : aes_cipher<T>(typename aes_cipher<T>::uninitialized_key_tag()) {
+            this->copy_key_from(other);
+        }
+
+        /**
+         *  Move constructor.
+         */
+        key_preserving_aes_cipher(key_preserving_aes_cipher &&other) noexcept = default;
+
+        /**
+         *  Copy assignment operator. Copies the key material of the other.
+         */
+        key_preserving_aes_cipher &operator=(const key_preserving_aes_cipher &other) {
+            this->copy_key_from(other);
+            return *this;
+        }
+
+        /**
+         *  Move assignment operator.
+         */
+        key_preserving_aes_cipher &operator=(key_preserving_aes_cipher &&other) noexcept = default;
+
+        /**
+         *  Returns an independently keyed cipher, for handing a copied value its own
+         *  fresh key where the key-preserving copy is not wanted.
+         */
+        key_preserving_aes_cipher clone_rekeyed() const {
+            return key_preserving_aes_cipher();
+        }
+    };
+
+    /**
+     *  The Alias of cipher_value using the aes_128_ecb algorithm whose copies keep the
+     *  key, so that copying the value is a bitwise block copy plus one key schedule
+     *  expansion.
+     *
+     *  @tparam T The type of the unencrypted value.
+     */
+    template <class T>
+    using key_preserving_aes_cipher_value = cipher_value<T, key_preserving_aes_cipher>;
 }
 
 #endif /* defined(__ferrum__aes_cipher_value__) */
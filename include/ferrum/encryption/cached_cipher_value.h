@@ -0,0 +1,209 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Daisuke Itabashi (https://github.com/idaisuke/ferrum)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef __ferrum__cached_cipher_value__
+#define __ferrum__cached_cipher_value__
+
+#include <type_traits>
+#include <utility>
+
+#include "cipher_value.h"
+
+namespace fe {
+
+    /**
+     *  Provides an encrypted value like fe::cipher_value, but with deferred re-encryption.
+     *  Mutations are applied to a decrypted scratch value guarded by a dirty flag, so a run
+     *  of consecutive arithmetic operations costs at most one decrypt up front and one
+     *  encrypt when the value is published, instead of a full decrypt/encrypt round trip
+     *  per operation. Publication happens on conversion to value_type and on an explicit
+     *  flush(); until then the scratch value lives unencrypted in memory, which is the
+     *  trade-off that makes this type opt-in.
+     *
+     *  ~~~~~~~~~~
+     *  fe::cached_cipher_value<int, fe::xor_cipher> encrypted_value;
+     *
+     *  encrypted_value = 12345;
+     *
+     *  // coalesced on the plaintext scratch value, no crypto per operation.
+     *  encrypted_value += 1;
+     *  encrypted_value += 2;
+     *  encrypted_value *= 3;
+     *
+     *  // re-encrypts once and scrubs the scratch value.
+     *  int unencrypted_value = encrypted_value;
+     *  ~~~~~~~~~~
+     *
+     *  @tparam T      The type of the unencrypted value.
+     *  @tparam Cipher A cryptographic cipher for encryption and decryption.
+     *
+     *  @see fe::cipher_value
+     */
+    template <class T, template <class> class Cipher>
+    class cached_cipher_value {
+    public:
+        /**
+         *  The type of the unencrypted value.
+         */
+        using value_type = T;
+
+        /**
+         *  The type of the cipher.
+         */
+        using cipher_type = Cipher<T>;
+
+        /**
+         *  The type of the encrypted value.
+         */
+        using encrypted_type = typename cipher_type::encrypted_type;
+
+        /**
+         *  Default constructor.
+         */
+        cached_cipher_value() : _cipher(cipher_type()), _cached(), _dirty(false) {
+        }
+
+        explicit cached_cipher_value(const cipher_type &cipher) : _cipher(cipher), _cached(), _dirty(false) {
+        }
+
+        cached_cipher_value(const value_type &value, const cipher_type &cipher = cipher_type())
+            : _cipher(cipher), _encrypted(_cipher.encrypt(value)), _cached(), _dirty(false) {
+        }
+
+        /**
+         *  Copy constructor. Publishes the other value first, so no plaintext is copied.
+         */
+        cached_cipher_value(const cached_cipher_value &other)
+            : _cipher(other._cipher),
+              _encrypted(_cipher.encrypt(static_cast<value_type>(other))),
+              _cached(),
+              _dirty(false) {
+        }
+
+        /**
+         *  Move constructor.
+         */
+        cached_cipher_value(cached_cipher_value &&other) noexcept(
+            std::is_nothrow_move_constructible<cipher_type>::value
+                &&std::is_nothrow_move_constructible<encrypted_type>::value
+                    &&std::is_nothrow_move_constructible<value_type>::value)
+            : _cipher(std::move(other._cipher)),
+              _encrypted(std::move(other._encrypted)),
+              _cached(std::move(other._cached)),
+              _dirty(other._dirty) {
+        }
+
+        /**
+         *  Copy assignment operator.
+         */
+        cached_cipher_value &operator=(const cached_cipher_value &other) {
+            _encrypted = _cipher.encrypt(static_cast<value_type>(other));
+            _cached = value_type();
+            _dirty = false;
+            return *this;
+        }
+
+        /**
+         *  Move assignment operator.
+         */
+        cached_cipher_value &operator=(cached_cipher_value &&other) {
+            _cipher = std::move(other._cipher);
+            _encrypted = std::move(other._encrypted);
+            _cached = std::move(other._cached);
+            _dirty = other._dirty;
+            return *this;
+        }
+
+        cached_cipher_value &operator=(const value_type &unencrypted) {
+            _cached = unencrypted;
+            _dirty = true;
+            return *this;
+        }
+
+        cached_cipher_value &operator=(value_type &&unencrypted) {
+            _cached = std::move(unencrypted);
+            _dirty = true;
+            return *this;
+        }
+
+        cached_cipher_value &operator+=(const value_type &unencrypted) {
+            scratch() += unencrypted;
+            return *this;
+        }
+
+        cached_cipher_value &operator-=(const value_type &unencrypted) {
+            scratch() -= unencrypted;
+            return *this;
+        }
+
+        cached_cipher_value &operator*=(const value_type &unencrypted) {
+            scratch() *= unencrypted;
+            return *this;
+        }
+
+        cached_cipher_value &operator/=(const value_type &unencrypted) {
+            scratch() /= unencrypted;
+            return *this;
+        }
+
+        /**
+         *  Re-encrypts the scratch value and scrubs it if any deferred mutation is
+         *  pending, so that no plaintext outlives the call.
+         */
+        void flush() const {
+            if (_dirty) {
+                _encrypted = _cipher.encrypt(_cached);
+                _cached = value_type();
+                _dirty = false;
+            }
+        }
+
+        operator value_type() const {
+            if (_dirty) {
+                auto result = _cached;
+                flush();
+                return result;
+            }
+            return _cipher.decrypt(_encrypted);
+        }
+
+    private:
+        /**
+         *  Returns the scratch value for mutation, decrypting the published value into it
+         *  first when no deferred mutation is pending yet.
+         */
+        value_type &scratch() {
+            if (!_dirty) {
+                _cached = _cipher.decrypt(_encrypted);
+                _dirty = true;
+            }
+            return _cached;
+        }
+
+        cipher_type _cipher;
+        mutable encrypted_type _encrypted;
+        mutable value_type _cached;
+        mutable bool _dirty;
+    };
+}
+
+#endif /* defined(__ferrum__cached_cipher_value__) */
@@ -0,0 +1,257 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Daisuke Itabashi (https://github.com/idaisuke/ferrum)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef __ferrum__cipher_array__
+#define __ferrum__cipher_array__
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+#include "aes_cipher_value.h"
+#include "cipher_value.h"
+
+namespace fe {
+
+    /**
+     *  Provides a fixed-size array of values encrypted together under a single key,
+     *  packed into the minimal whole number of cipher blocks.
+     *  Where an array of fe::aes_cipher_value<int> pads every 4 byte value into its own
+     *  16 byte block with its own key — 8x space overhead and one cipher call per
+     *  element — a cipher_array<int, 16> packs the 16 values into 4 blocks and
+     *  encrypts or decrypts them all in one pass, so reading the whole array costs one
+     *  call into the cipher and the space overhead is only the padding of the last
+     *  block.
+     *
+     *  Elements are intended to be accessed together: get and set decrypt or re-encrypt
+     *  the whole array, which is the point for small stat blocks read as a unit.
+     *
+     *  ~~~~~~~~~~
+     *  fe::cipher_array<int, 16> stats;
+     *
+     *  stats.store({{...}});           // one pass over 4 blocks
+     *  std::array<int, 16> plain = stats.load();
+     *  ~~~~~~~~~~
+     *
+     *  @tparam T      The type of the unencrypted elements. Must be trivially copyable.
+     *  @tparam N      The number of elements.
+     *  @tparam Cipher A cryptographic cipher providing encrypt_blocks and
+     *                 decrypt_blocks, such as fe::aes_cipher.
+     */
+    template <class T, std::size_t N, template <class> class Cipher = aes_cipher>
+    class cipher_array : private Cipher<T> {
+        static_assert(std::is_trivially_copyable<T>::value, "cipher_array requires a trivially copyable type");
+        static_assert(N > 0, "cipher_array requires a non-zero element count");
+
+    public:
+        /**
+         *  The type of the unencrypted elements.
+         */
+        using value_type = T;
+
+        /**
+         *  The type of the cipher.
+         */
+        using cipher_type = Cipher<T>;
+
+        /**
+         *  The unsigned integral type of the size of the array.
+         */
+        using size_type = std::size_t;
+
+        /**
+         *  The size of one cipher block in bytes.
+         */
+        static constexpr size_type block_size = sizeof(typename cipher_type::encrypted_type);
+
+        /**
+         *  The number of whole cipher blocks the N elements are packed into.
+         */
+        static constexpr size_type block_count = (sizeof(value_type) * N + block_size - 1) / block_size;
+
+        /**
+         *  The type of the encrypted payload.
+         */
+        using encrypted_type = std::array<unsigned char, block_count * block_size>;
+
+        /**
+         *  Default constructor. Encrypts an array of value-initialized elements.
+         */
+        cipher_array() : cipher_type() {
+            store(std::array<value_type, N>());
+        }
+
+        /**
+         *  Constructs the array with the encrypted copies of the given values.
+         *
+         *  @param values The values to encrypt.
+         */
+        cipher_array(const std::array<value_type, N> &values) : cipher_type() {
+            store(values);
+        }
+
+        /**
+         *  Copy constructor. When the cipher preserves its key on copy (see
+         *  fe::preserves_key_on_copy), the encrypted blocks are copied bitwise;
+         *  otherwise the array is decrypted under the other's key and re-encrypted
+         *  under the fresh one, one pass each.
+         */
+        cipher_array(const cipher_array &other)
+            : cipher_array(other, typename preserves_key_on_copy<cipher_type>::type()) {
+        }
+
+        /**
+         *  Move constructor.
+         */
+        cipher_array(cipher_array &&other) noexcept(std::is_nothrow_move_constructible<cipher_type>::value)
+            : cipher_type(std::move(other.cipher())), _encrypted(other._encrypted) {
+        }
+
+        /**
+         *  Copy assignment operator. Like the copy constructor, a key-preserving cipher
+         *  makes this a plain assignment of the cipher and the encrypted blocks.
+         */
+        cipher_array &operator=(const cipher_array &other) {
+            assign(other, typename preserves_key_on_copy<cipher_type>::type());
+            return *this;
+        }
+
+        /**
+         *  Move assignment operator.
+         */
+        cipher_array &operator=(cipher_array &&other) noexcept(std::is_nothrow_move_assignable<cipher_type>::value) {
+            cipher() = std::move(other.cipher());
+            _encrypted = other._encrypted;
+            return *this;
+        }
+
+        /**
+         *  Returns the number of elements.
+         */
+        constexpr size_type size() const noexcept {
+            return N;
+        }
+
+        /**
+         *  Decrypts all elements in one pass.
+         */
+        std::array<value_type, N> load() const {
+            typename std::aligned_storage<block_count * block_size, alignof(value_type)>::type buffer;
+            auto bytes = reinterpret_cast<unsigned char *>(&buffer);
+            this->decrypt_blocks(_encrypted.data(), block_count, bytes);
+            std::array<value_type, N> values;
+            std::memcpy(values.data(), bytes, sizeof(values));
+            return values;
+        }
+
+        /**
+         *  Encrypts all elements in one pass, padding the last block with zeros.
+         *
+         *  @param values The values to encrypt.
+         */
+        void store(const std::array<value_type, N> &values) {
+            typename std::aligned_storage<block_count * block_size, alignof(value_type)>::type buffer;
+            auto bytes = reinterpret_cast<unsigned char *>(&buffer);
+            std::memset(bytes, 0, block_count * block_size);
+            std::memcpy(bytes, values.data(), sizeof(values));
+            this->encrypt_blocks(bytes, block_count, _encrypted.data());
+        }
+
+        /**
+         *  Gets the decrypted n-th element. Decrypts the whole array; prefer load() when
+         *  reading more than one element.
+         */
+        value_type get(size_type n) const {
+            return load()[n];
+        }
+
+        /**
+         *  Gets the decrypted n-th element.
+         */
+        value_type operator[](size_type n) const {
+            return get(n);
+        }
+
+        /**
+         *  Encrypts the given value into the n-th element; a decrypt and re-encrypt pass
+         *  over the whole array.
+         *
+         *  @param n     The index of the element.
+         *  @param value The value to encrypt and store.
+         */
+        void set(size_type n, const value_type &value) {
+            auto values = load();
+            values[n] = value;
+            store(values);
+        }
+
+        /**
+         *  Compares the decrypted contents of two arrays.
+         */
+        friend bool operator==(const cipher_array &lhs, const cipher_array &rhs) {
+            return lhs.load() == rhs.load();
+        }
+
+        /**
+         *  Compares the decrypted contents of two arrays.
+         */
+        friend bool operator!=(const cipher_array &lhs, const cipher_array &rhs) {
+            return !(lhs == rhs);
+        }
+
+    private:
+        cipher_array(const cipher_array &other, std::true_type)
+            : cipher_type(other.cipher()), _encrypted(other._encrypted) {
+        }
+
+        cipher_array(const cipher_array &other, std::false_type) : cipher_type() {
+            store(other.load());
+        }
+
+        void assign(const cipher_array &other, std::true_type) {
+            cipher() = other.cipher();
+            _encrypted = other._encrypted;
+        }
+
+        void assign(const cipher_array &other, std::false_type) {
+            store(other.load());
+        }
+
+        /**
+         *  The cipher is held as a private base instead of a member, like cipher_value,
+         *  so that an empty (shared-key) cipher adds no per-instance state.
+         */
+        cipher_type &cipher() noexcept {
+            return *this;
+        }
+
+        const cipher_type &cipher() const noexcept {
+            return *this;
+        }
+
+        encrypted_type _encrypted;
+    };
+}
+
+#endif /* defined(__ferrum__cipher_array__) */
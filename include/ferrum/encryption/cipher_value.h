@@ -23,11 +23,33 @@
 #ifndef __ferrum__cipher_value__
 #define __ferrum__cipher_value__
 
+#include <cstddef>
+#include <istream>
+#include <ostream>
 #include <type_traits>
 #include <utility>
 
 namespace fe {
 
+    /**
+     *  Detects whether copying the cipher preserves its key material, i.e. whether a
+     *  copy decrypts what the original encrypted. Ciphers opt in by declaring the
+     *  member type key_preserving_copy as std::true_type; fe::cipher_value then copies
+     *  the encrypted payload bitwise instead of decrypting under the old key and
+     *  re-encrypting under the new one.
+     */
+    template <class C>
+    class preserves_key_on_copy {
+        template <class U>
+        static typename U::key_preserving_copy test(const U *);
+
+        template <class U>
+        static std::false_type test(...);
+
+    public:
+        using type = decltype(test<C>(nullptr));
+    };
+
     /**
      *  Provides a value that is encrypted that can be used in the same way as the primitive type.
      *
@@ -50,7 +72,7 @@ namespace fe {
      *  @see fe::xor_cipher_value, fe::aes_cipher_value
      */
     template <class T, template <class> class Cipher>
-    class cipher_value {
+    class cipher_value : private Cipher<T> {
     public:
         /**
          *  The type of the unencrypted value.
@@ -70,29 +92,32 @@ namespace fe {
         /**
          *  Default constructor.
          */
-        cipher_value() : _cipher(cipher_type()) {
+        cipher_value() : cipher_type() {
         }
 
-        explicit cipher_value(const cipher_type &cipher) : _cipher(cipher) {
+        explicit cipher_value(const cipher_type &cipher) : cipher_type(cipher) {
         }
 
         cipher_value(const value_type &value, const cipher_type &cipher = cipher_type())
-            : _cipher(cipher), _encrypted(_cipher.encrypt(value)) {
+            : cipher_type(cipher), _encrypted(this->encrypt(value)) {
         }
 
         cipher_value(value_type &&value, const cipher_type &cipher = cipher_type())
-            : _cipher(cipher), _encrypted(_cipher.encrypt(std::move(value))) {
+            : cipher_type(cipher), _encrypted(this->encrypt(std::move(value))) {
         }
 
         /**
-         *  Copy constructor.
+         *  Copy constructor. When the cipher preserves its key on copy (see
+         *  fe::preserves_key_on_copy), the encrypted payload is copied bitwise with zero
+         *  crypto work; otherwise the value is decrypted under the other's key and
+         *  re-encrypted under the fresh one.
          */
         cipher_value(const cipher_value &other)
-            : _cipher(other._cipher), _encrypted(_cipher.encrypt(static_cast<value_type>(other))) {
+            : cipher_value(other, typename preserves_key_on_copy<cipher_type>::type()) {
         }
 
         cipher_value(const cipher_value &other, const cipher_type &cipher)
-            : _cipher(cipher), _encrypted(_cipher.encrypt(static_cast<value_type>(other))) {
+            : cipher_type(cipher), _encrypted(this->encrypt(static_cast<value_type>(other))) {
         }
 
         /**
@@ -100,18 +125,19 @@ namespace fe {
          */
         cipher_value(cipher_value &&other) noexcept(std::is_nothrow_move_constructible<cipher_type>::value
                                                         &&std::is_nothrow_move_constructible<encrypted_type>::value)
-            : _cipher(std::move(other._cipher)), _encrypted(std::move(other._encrypted)) {
+            : cipher_type(std::move(other.cipher())), _encrypted(std::move(other._encrypted)) {
         }
 
         cipher_value(cipher_value &&other, const cipher_type &cipher)
-            : _cipher(cipher), _encrypted(_cipher.encrypt(static_cast<value_type>(std::move(other)))) {
+            : cipher_type(cipher), _encrypted(this->encrypt(static_cast<value_type>(std::move(other)))) {
         }
 
         /**
-         *  Copy assignment operator.
+         *  Copy assignment operator. Like the copy constructor, a key-preserving cipher
+         *  makes this a plain assignment of the cipher and the encrypted payload.
          */
         cipher_value &operator=(const cipher_value &other) {
-            _encrypted = _cipher.encrypt(static_cast<value_type>(other));
+            assign(other, typename preserves_key_on_copy<cipher_type>::type());
             return *this;
         }
 
@@ -120,118 +146,246 @@ namespace fe {
          */
         cipher_value &operator=(cipher_value &&other) noexcept(std::is_nothrow_move_assignable<
             cipher_type>::value &&std::is_nothrow_move_assignable<encrypted_type>::value) {
-            _cipher = std::move(other._cipher);
+            cipher() = std::move(other.cipher());
             _encrypted = std::move(other._encrypted);
             return *this;
         }
 
         cipher_value &operator=(const value_type &unencrypted) {
-            _encrypted = _cipher.encrypt(unencrypted);
+            _encrypted = this->encrypt(unencrypted);
             return *this;
         }
 
         cipher_value &operator=(value_type &&unencrypted) {
-            _encrypted = _cipher.encrypt(std::move(unencrypted));
+            _encrypted = this->encrypt(std::move(unencrypted));
             return *this;
         }
 
         cipher_value &operator+=(const cipher_value &other) {
-            _encrypted = _cipher.encrypt(static_cast<value_type>(std::move(*this)) + static_cast<value_type>(other));
+            _encrypted = this->encrypt(static_cast<value_type>(std::move(*this)) + static_cast<value_type>(other));
             return *this;
         }
 
         cipher_value &operator+=(cipher_value &&other) {
             _encrypted =
-                _cipher.encrypt(static_cast<value_type>(std::move(*this)) + static_cast<value_type>(std::move(other)));
+                this->encrypt(static_cast<value_type>(std::move(*this)) + static_cast<value_type>(std::move(other)));
             return *this;
         }
 
         cipher_value &operator+=(const value_type &unencrypted) {
-            _encrypted = _cipher.encrypt(static_cast<value_type>(std::move(*this)) + unencrypted);
+            _encrypted = this->encrypt(static_cast<value_type>(std::move(*this)) + unencrypted);
             return *this;
         }
 
         cipher_value &operator+=(value_type &&unencrypted) {
-            _encrypted = _cipher.encrypt(static_cast<value_type>(std::move(*this)) + std::move(unencrypted));
+            _encrypted = this->encrypt(static_cast<value_type>(std::move(*this)) + std::move(unencrypted));
             return *this;
         }
 
         cipher_value &operator-=(const cipher_value &other) {
-            _encrypted = _cipher.encrypt(static_cast<value_type>(std::move(*this)) - static_cast<value_type>(other));
+            _encrypted = this->encrypt(static_cast<value_type>(std::move(*this)) - static_cast<value_type>(other));
             return *this;
         }
 
         cipher_value &operator-=(cipher_value &&other) {
             _encrypted =
-                _cipher.encrypt(static_cast<value_type>(std::move(*this)) - static_cast<value_type>(std::move(other)));
+                this->encrypt(static_cast<value_type>(std::move(*this)) - static_cast<value_type>(std::move(other)));
             return *this;
         }
 
         cipher_value &operator-=(const value_type &unencrypted) {
-            _encrypted = _cipher.encrypt(static_cast<value_type>(std::move(*this)) - unencrypted);
+            _encrypted = this->encrypt(static_cast<value_type>(std::move(*this)) - unencrypted);
             return *this;
         }
 
         cipher_value &operator-=(value_type &&unencrypted) {
-            _encrypted = _cipher.encrypt(static_cast<value_type>(std::move(*this)) - std::move(unencrypted));
+            _encrypted = this->encrypt(static_cast<value_type>(std::move(*this)) - std::move(unencrypted));
             return *this;
         }
 
         cipher_value &operator*=(const cipher_value &other) {
-            _encrypted = _cipher.encrypt(static_cast<value_type>(std::move(*this)) * static_cast<value_type>(other));
+            _encrypted = this->encrypt(static_cast<value_type>(std::move(*this)) * static_cast<value_type>(other));
             return *this;
         }
 
         cipher_value &operator*=(cipher_value &&other) {
             _encrypted =
-                _cipher.encrypt(static_cast<value_type>(std::move(*this)) * static_cast<value_type>(std::move(other)));
+                this->encrypt(static_cast<value_type>(std::move(*this)) * static_cast<value_type>(std::move(other)));
             return *this;
         }
 
         cipher_value &operator*=(const value_type &unencrypted) {
-            _encrypted = _cipher.encrypt(static_cast<value_type>(std::move(*this)) * unencrypted);
+            _encrypted = this->encrypt(static_cast<value_type>(std::move(*this)) * unencrypted);
             return *this;
         }
 
         cipher_value &operator*=(value_type &&unencrypted) {
-            _encrypted = _cipher.encrypt(static_cast<value_type>(std::move(*this)) * std::move(unencrypted));
+            _encrypted = this->encrypt(static_cast<value_type>(std::move(*this)) * std::move(unencrypted));
             return *this;
         }
 
         cipher_value &operator/=(const cipher_value &other) {
-            _encrypted = _cipher.encrypt(static_cast<value_type>(std::move(*this)) / static_cast<value_type>(other));
+            _encrypted = this->encrypt(static_cast<value_type>(std::move(*this)) / static_cast<value_type>(other));
             return *this;
         }
 
         cipher_value &operator/=(cipher_value &&other) {
             _encrypted =
-                _cipher.encrypt(static_cast<value_type>(std::move(*this)) / static_cast<value_type>(std::move(other)));
+                this->encrypt(static_cast<value_type>(std::move(*this)) / static_cast<value_type>(std::move(other)));
             return *this;
         }
 
         cipher_value &operator/=(const value_type &unencrypted) {
-            _encrypted = _cipher.encrypt(static_cast<value_type>(std::move(*this)) / unencrypted);
+            _encrypted = this->encrypt(static_cast<value_type>(std::move(*this)) / unencrypted);
             return *this;
         }
 
         cipher_value &operator/=(value_type &&unencrypted) {
-            _encrypted = _cipher.encrypt(static_cast<value_type>(std::move(*this)) / std::move(unencrypted));
+            _encrypted = this->encrypt(static_cast<value_type>(std::move(*this)) / std::move(unencrypted));
             return *this;
         }
 
         operator value_type() const & {
-            return _cipher.decrypt(_encrypted);
+            return this->decrypt(_encrypted);
         }
 
         operator value_type() && {
-            return _cipher.decrypt(std::move(_encrypted));
+            return this->decrypt(std::move(_encrypted));
+        }
+
+        /**
+         *  Writes the encrypted payload to the stream as raw bytes, with zero crypto
+         *  work: the value is persisted as ciphertext and never exists decrypted
+         *  outside the process, where the formatted stream operators decrypt on output.
+         *  The bytes are only meaningful to a cipher holding the key that produced
+         *  them: the shared-key policies within one process lifetime, a key-preserving
+         *  copy of the writing value, or fe::static_xor_cipher across processes.
+         *
+         *  @param os The stream to write to.
+         */
+        std::ostream &write_encrypted(std::ostream &os) const {
+            static_assert(std::is_trivially_copyable<encrypted_type>::value,
+                          "write_encrypted requires a trivially copyable encrypted type");
+            return os.write(reinterpret_cast<const char *>(&_encrypted), sizeof(_encrypted));
+        }
+
+        /**
+         *  Replaces the encrypted payload with raw bytes read from the stream, the
+         *  inverse of write_encrypted, with zero crypto work. The payload must have
+         *  been written under the key this value's cipher holds.
+         *
+         *  @param is The stream to read from.
+         */
+        std::istream &read_encrypted(std::istream &is) {
+            static_assert(std::is_trivially_copyable<encrypted_type>::value,
+                          "read_encrypted requires a trivially copyable encrypted type");
+            return is.read(reinterpret_cast<char *>(&_encrypted), sizeof(_encrypted));
         }
 
     private:
-        cipher_type _cipher;
+        cipher_value(const cipher_value &other, std::true_type)
+            : cipher_type(other.cipher()), _encrypted(other._encrypted) {
+        }
+
+        cipher_value(const cipher_value &other, std::false_type)
+            : cipher_type(other.cipher()), _encrypted(this->encrypt(static_cast<value_type>(other))) {
+        }
+
+        void assign(const cipher_value &other, std::true_type) {
+            cipher() = other.cipher();
+            _encrypted = other._encrypted;
+        }
+
+        void assign(const cipher_value &other, std::false_type) {
+            _encrypted = this->encrypt(static_cast<value_type>(other));
+        }
+
+        /**
+         *  The cipher is held as a private base instead of a member, so that an empty
+         *  (shared-key) cipher adds no per-instance state and the footprint shrinks to
+         *  just encrypted_type.
+         */
+        cipher_type &cipher() noexcept {
+            return *this;
+        }
+
+        const cipher_type &cipher() const noexcept {
+            return *this;
+        }
+
         encrypted_type _encrypted;
+
+        template <class T1, template <class> class Cipher1>
+        friend void encrypt_range(const T1 *, std::size_t, cipher_value<T1, Cipher1> *);
+
+        template <class T1, template <class> class Cipher1>
+        friend void decrypt_range(const cipher_value<T1, Cipher1> *, std::size_t, T1 *);
     };
 
+    /**
+     *  Encrypts count values from the given span in place of the corresponding elements
+     *  of out, each with its own cipher. The loop runs directly over the contiguous
+     *  elements with no per-call conversion overhead, so cheap ciphers such as
+     *  fe::xor_cipher vectorize over the span.
+     *
+     *  @param unencrypted The span of values to encrypt.
+     *  @param count       The number of values.
+     *  @param out         The span of encrypted values to store the result in.
+     */
+    template <class T, template <class> class Cipher>
+    void encrypt_range(const T *unencrypted, std::size_t count, cipher_value<T, Cipher> *out) {
+        for (std::size_t i = 0; i < count; ++i) {
+            out[i]._encrypted = out[i].cipher().encrypt(unencrypted[i]);
+        }
+    }
+
+    /**
+     *  Decrypts count elements of the given span into out, each with its own cipher.
+     *
+     *  @param encrypted The span of encrypted values to decrypt.
+     *  @param count     The number of values.
+     *  @param out       The span of values to store the result in.
+     */
+    template <class T, template <class> class Cipher>
+    void decrypt_range(const cipher_value<T, Cipher> *encrypted, std::size_t count, T *out) {
+        for (std::size_t i = 0; i < count; ++i) {
+            out[i] = encrypted[i].cipher().decrypt(encrypted[i]._encrypted);
+        }
+    }
+
+    /**
+     *  Writes the encrypted payloads of count elements of the given span to the stream
+     *  as raw bytes (see cipher_value::write_encrypted): persisting a span moves
+     *  ciphertext only, with zero crypto work.
+     *
+     *  @param values The span of encrypted values to write.
+     *  @param count  The number of values.
+     *  @param os     The stream to write to.
+     */
+    template <class T, template <class> class Cipher>
+    std::ostream &write_encrypted_range(const cipher_value<T, Cipher> *values, std::size_t count, std::ostream &os) {
+        for (std::size_t i = 0; i < count; ++i) {
+            values[i].write_encrypted(os);
+        }
+        return os;
+    }
+
+    /**
+     *  Replaces the encrypted payloads of count elements of the given span with raw
+     *  bytes read from the stream, the inverse of write_encrypted_range.
+     *
+     *  @param values The span of encrypted values to read into.
+     *  @param count  The number of values.
+     *  @param is     The stream to read from.
+     */
+    template <class T, template <class> class Cipher>
+    std::istream &read_encrypted_range(cipher_value<T, Cipher> *values, std::size_t count, std::istream &is) {
+        for (std::size_t i = 0; i < count; ++i) {
+            values[i].read_encrypted(is);
+        }
+        return is;
+    }
+
     template <class T, template <class> class Cipher>
     cipher_value<T, Cipher> operator+(const cipher_value<T, Cipher> &lhs) {
         return lhs;
@@ -0,0 +1,85 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Daisuke Itabashi (https://github.com/idaisuke/ferrum)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef __ferrum__splitmix64__
+#define __ferrum__splitmix64__
+
+#include <cstdint>
+
+namespace fe {
+
+    /**
+     *  Represents the splitmix64 random number engine, usable with the standard
+     *  distributions. The whole engine is a single 64 bit counter and a few multiplies
+     *  per draw, which makes it cheap enough to keep one instance per thread for key
+     *  generation, where a std::mt19937 per thread would be needlessly large.
+     */
+    class splitmix64 {
+    public:
+        /**
+         *  The unsigned integral type of the generated values.
+         */
+        using result_type = std::uint64_t;
+
+        /**
+         *  Constructs the engine with the given seed.
+         */
+        explicit splitmix64(result_type seed = 0) noexcept : _state(seed) {
+        }
+
+        /**
+         *  Returns the smallest possible value.
+         */
+        static constexpr result_type min() {
+            return 0;
+        }
+
+        /**
+         *  Returns the largest possible value.
+         */
+        static constexpr result_type max() {
+            return UINT64_MAX;
+        }
+
+        /**
+         *  Generates the next value.
+         */
+        result_type operator()() noexcept {
+            auto z = (_state += UINT64_C(0x9e3779b97f4a7c15));
+            z = (z ^ (z >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+            z = (z ^ (z >> 27)) * UINT64_C(0x94d049bb133111eb);
+            return z ^ (z >> 31);
+        }
+
+        /**
+         *  Reseeds the engine.
+         */
+        void seed(result_type seed) noexcept {
+            _state = seed;
+        }
+
+    private:
+        result_type _state;
+    };
+}
+
+#endif /* defined(__ferrum__splitmix64__) */
@@ -0,0 +1,96 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Daisuke Itabashi (https://github.com/idaisuke/ferrum)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef __ferrum__static_xor_cipher_value__
+#define __ferrum__static_xor_cipher_value__
+
+#include <cstdint>
+#include <type_traits>
+
+#include "cipher_value.h"
+
+namespace fe {
+
+    /**
+     *  Represents a xor cipher with a build-time key and salt. encrypt and decrypt are
+     *  constexpr, so a value obfuscated with this cipher is encrypted entirely at compile
+     *  time and the decrypt folds to two ALU operations inline — no runtime random engine,
+     *  no startup cost. Intended for obfuscating tuning constants against memory scanners;
+     *  a key that is part of the binary offers no secrecy beyond that.
+     *
+     *  @tparam T    The type of the unencrypted value. Must be an integral type.
+     *  @tparam Key  The build-time key.
+     *  @tparam Salt The build-time salt.
+     */
+    template <class T, std::uint64_t Key, std::uint64_t Salt>
+    class static_xor_cipher {
+        static_assert(std::is_integral<T>::value, "static_xor_cipher requires an integral type");
+
+    public:
+        using value_type = T;
+        using encrypted_type = value_type;
+
+        /**
+         *  The key and salt are build-time constants, so copies trivially decrypt what
+         *  the original encrypted (see fe::preserves_key_on_copy).
+         */
+        using key_preserving_copy = std::true_type;
+
+        constexpr encrypted_type encrypt(const value_type &unencrypted) const {
+            return (unencrypted ^ static_cast<encrypted_type>(Key)) + static_cast<encrypted_type>(Salt);
+        }
+
+        constexpr value_type decrypt(const encrypted_type &encrypted) const {
+            return (encrypted - static_cast<encrypted_type>(Salt)) ^ static_cast<encrypted_type>(Key);
+        }
+    };
+
+    /**
+     *  Binds a build-time key and salt, exposing the cipher as a template over the value
+     *  type so that it fits cipher_value's template template parameter.
+     *
+     *  ~~~~~~~~~~
+     *  using tuning_cipher = fe::static_xor_key<0x9e3779b97f4a7c15, 0x7f4a7c15>;
+     *  fe::cipher_value<int, tuning_cipher::cipher> obfuscated_constant(12345);
+     *  ~~~~~~~~~~
+     *
+     *  @tparam Key  The build-time key.
+     *  @tparam Salt The build-time salt.
+     */
+    template <std::uint64_t Key, std::uint64_t Salt>
+    struct static_xor_key {
+        template <class T>
+        using cipher = static_xor_cipher<T, Key, Salt>;
+    };
+
+    /**
+     *  The Alias of cipher_value using the xor algorithm with a build-time key and salt.
+     *
+     *  @tparam T    The type of the unencrypted value. Must be an integral type.
+     *  @tparam Key  The build-time key.
+     *  @tparam Salt The build-time salt.
+     */
+    template <class T, std::uint64_t Key, std::uint64_t Salt>
+    using static_xor_cipher_value = cipher_value<T, static_xor_key<Key, Salt>::template cipher>;
+}
+
+#endif /* defined(__ferrum__static_xor_cipher_value__) */
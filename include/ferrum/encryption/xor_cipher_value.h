@@ -23,12 +23,19 @@
 #ifndef __ferrum__xor_cipher_value__
 #define __ferrum__xor_cipher_value__
 
+#include <cstddef>
 #include <cstdint>
 #include <limits>
 #include <random>
 #include <type_traits>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "../stats.h"
 #include "cipher_value.h"
+#include "splitmix64.h"
 
 namespace fe {
     template <class T>
@@ -62,13 +69,19 @@ namespace fe {
     private:
         xor_cipher_value_random_engine_holder() = delete;
 
-        static std::random_device::result_type get_seed() {
+        static splitmix64::result_type get_seed() {
             std::random_device gen;
-            return gen();
+            return (static_cast<splitmix64::result_type>(gen()) << 32) | gen();
         }
 
-        static std::mt19937 &get() {
-            static std::mt19937 engine(get_seed());
+        /**
+         *  Returns the calling thread's key generation engine. One engine per thread
+         *  keeps concurrent cipher construction race-free and scalable, where the
+         *  previous single shared engine was both a data race and a serialization
+         *  point.
+         */
+        static splitmix64 &get() {
+            static thread_local splitmix64 engine(get_seed());
             return engine;
         }
 
@@ -118,17 +131,168 @@ namespace fe {
         basic_int_xor_cipher &operator=(basic_int_xor_cipher &&other) noexcept = default;
 
         encrypted_type encrypt(const value_type &unencrypted) const {
-            return (unencrypted ^ _key) + _salt;
+            global_cipher_stats().record_encrypt(1);
+            return encrypt_value(unencrypted);
         }
 
         value_type decrypt(const encrypted_type &encrypted) const {
-            return (encrypted - _salt) ^ _key;
+            global_cipher_stats().record_decrypt(1);
+            return decrypt_value(encrypted);
+        }
+
+        /**
+         *  Encrypts count values with this cipher's key in one pass. When the translation
+         *  unit is compiled with AVX2 the span is processed 32 bytes per instruction, with
+         *  a scalar loop for the tail; otherwise the whole span runs scalar.
+         */
+        void encrypt_n(const value_type *unencrypted, std::size_t count, encrypted_type *out) const {
+            global_cipher_stats().record_encrypt(count);
+            encrypt_span(unencrypted, count, out);
+        }
+
+        /**
+         *  Decrypts count values with this cipher's key in one pass, vectorized like
+         *  encrypt_n.
+         */
+        void decrypt_n(const encrypted_type *encrypted, std::size_t count, value_type *out) const {
+            global_cipher_stats().record_decrypt(count);
+            decrypt_span(encrypted, count, out);
         }
 
     private:
+        encrypted_type encrypt_value(const value_type &unencrypted) const {
+            return (unencrypted ^ _key) + _salt;
+        }
+
+        value_type decrypt_value(const encrypted_type &encrypted) const {
+            return (encrypted - _salt) ^ _key;
+        }
+
+        /**
+         *  The uninstrumented body of encrypt_n, so that the floating point cipher can
+         *  delegate its span to the integer kernel without the delegation being counted
+         *  as a second call.
+         */
+        void encrypt_span(const value_type *unencrypted, std::size_t count, encrypted_type *out) const {
+            std::size_t i = bulk_forward(unencrypted, count, out, simd_tag());
+            for (; i < count; ++i) {
+                out[i] = encrypt_value(unencrypted[i]);
+            }
+        }
+
+        /**
+         *  The uninstrumented body of decrypt_n.
+         */
+        void decrypt_span(const encrypted_type *encrypted, std::size_t count, value_type *out) const {
+            std::size_t i = bulk_backward(encrypted, count, out, simd_tag());
+            for (; i < count; ++i) {
+                out[i] = decrypt_value(encrypted[i]);
+            }
+        }
+
         static constexpr encrypted_type LIMIT_MAX = std::numeric_limits<encrypted_type>::max();
         static constexpr encrypted_type LIMIT_MIN = std::numeric_limits<encrypted_type>::min();
 
+        using simd_tag =
+            std::integral_constant<bool, sizeof(encrypted_type) == 1 || sizeof(encrypted_type) == 2 ||
+                                             sizeof(encrypted_type) == 4 || sizeof(encrypted_type) == 8>;
+
+#if defined(__AVX2__)
+        using width_tag = std::integral_constant<std::size_t, sizeof(encrypted_type)>;
+
+        static __m256i splat(encrypted_type value, std::integral_constant<std::size_t, 1>) {
+            return _mm256_set1_epi8(static_cast<char>(value));
+        }
+
+        static __m256i splat(encrypted_type value, std::integral_constant<std::size_t, 2>) {
+            return _mm256_set1_epi16(static_cast<short>(value));
+        }
+
+        static __m256i splat(encrypted_type value, std::integral_constant<std::size_t, 4>) {
+            return _mm256_set1_epi32(static_cast<int>(value));
+        }
+
+        static __m256i splat(encrypted_type value, std::integral_constant<std::size_t, 8>) {
+            return _mm256_set1_epi64x(static_cast<long long>(value));
+        }
+
+        static __m256i add(__m256i lhs, __m256i rhs, std::integral_constant<std::size_t, 1>) {
+            return _mm256_add_epi8(lhs, rhs);
+        }
+
+        static __m256i add(__m256i lhs, __m256i rhs, std::integral_constant<std::size_t, 2>) {
+            return _mm256_add_epi16(lhs, rhs);
+        }
+
+        static __m256i add(__m256i lhs, __m256i rhs, std::integral_constant<std::size_t, 4>) {
+            return _mm256_add_epi32(lhs, rhs);
+        }
+
+        static __m256i add(__m256i lhs, __m256i rhs, std::integral_constant<std::size_t, 8>) {
+            return _mm256_add_epi64(lhs, rhs);
+        }
+
+        static __m256i sub(__m256i lhs, __m256i rhs, std::integral_constant<std::size_t, 1>) {
+            return _mm256_sub_epi8(lhs, rhs);
+        }
+
+        static __m256i sub(__m256i lhs, __m256i rhs, std::integral_constant<std::size_t, 2>) {
+            return _mm256_sub_epi16(lhs, rhs);
+        }
+
+        static __m256i sub(__m256i lhs, __m256i rhs, std::integral_constant<std::size_t, 4>) {
+            return _mm256_sub_epi32(lhs, rhs);
+        }
+
+        static __m256i sub(__m256i lhs, __m256i rhs, std::integral_constant<std::size_t, 8>) {
+            return _mm256_sub_epi64(lhs, rhs);
+        }
+
+        std::size_t bulk_forward(const value_type *in, std::size_t count, encrypted_type *out,
+                                 std::true_type) const {
+            constexpr std::size_t lanes = 32 / sizeof(encrypted_type);
+            auto key = splat(_key, width_tag());
+            auto salt = splat(_salt, width_tag());
+            std::size_t i = 0;
+            for (; i + lanes <= count; i += lanes) {
+                auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i));
+                block = add(_mm256_xor_si256(block, key), salt, width_tag());
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), block);
+            }
+            return i;
+        }
+
+        std::size_t bulk_backward(const encrypted_type *in, std::size_t count, value_type *out,
+                                  std::true_type) const {
+            constexpr std::size_t lanes = 32 / sizeof(encrypted_type);
+            auto key = splat(_key, width_tag());
+            auto salt = splat(_salt, width_tag());
+            std::size_t i = 0;
+            for (; i + lanes <= count; i += lanes) {
+                auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i));
+                block = _mm256_xor_si256(sub(block, salt, width_tag()), key);
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), block);
+            }
+            return i;
+        }
+#else
+        std::size_t bulk_forward(const value_type *, std::size_t, encrypted_type *, std::true_type) const {
+            return 0;
+        }
+
+        std::size_t bulk_backward(const encrypted_type *, std::size_t, value_type *, std::true_type) const {
+            return 0;
+        }
+#endif
+
+        std::size_t bulk_forward(const value_type *, std::size_t, encrypted_type *, std::false_type) const {
+            return 0;
+        }
+
+        std::size_t bulk_backward(const encrypted_type *, std::size_t, value_type *, std::false_type) const {
+            return 0;
+        }
+
         void init() {
             std::uniform_int_distribution<encrypted_type> dist(LIMIT_MIN, LIMIT_MAX);
             _key = dist(xor_cipher_value_random_engine_holder::get());
@@ -137,6 +301,19 @@ namespace fe {
 
         encrypted_type _key;
         encrypted_type _salt;
+
+        template <class T1, class IntType1, class>
+        friend class basic_real_xor_cipher;
+
+    protected:
+        /**
+         *  Copies the key material of the other instead of re-rolling it; for the
+         *  key-preserving policy classes (see fe::key_preserving_xor_cipher).
+         */
+        void copy_key_from(const basic_int_xor_cipher &other) noexcept {
+            _key = other._key;
+            _salt = other._salt;
+        }
     };
 
     template <class T, class IntType, class = typename std::enable_if<std::is_floating_point<T>::value, void>::type>
@@ -178,6 +355,7 @@ namespace fe {
         basic_real_xor_cipher &operator=(basic_real_xor_cipher &&other) noexcept = default;
 
         encrypted_type encrypt(const value_type &unencrypted) const {
+            global_cipher_stats().record_encrypt(1);
             converter converter;
             converter.real_value = unencrypted;
             converter.int_value = (converter.int_value ^ _key) + _salt;
@@ -185,12 +363,49 @@ namespace fe {
         }
 
         value_type decrypt(const encrypted_type &encrypted) const {
+            global_cipher_stats().record_decrypt(1);
             converter converter;
             converter.int_value = encrypted;
             converter.int_value = (converter.int_value - _salt) ^ _key;
             return converter.real_value;
         }
 
+        /**
+         *  Encrypts count values with this cipher's key in one pass: the values are packed
+         *  through the converter into the output span first, then the span is transformed
+         *  with the vectorized integer kernel instead of round-tripping through the union
+         *  one value at a time.
+         */
+        void encrypt_n(const value_type *unencrypted, std::size_t count, encrypted_type *out) const {
+            global_cipher_stats().record_encrypt(count);
+            for (std::size_t i = 0; i < count; ++i) {
+                converter converter;
+                converter.real_value = unencrypted[i];
+                out[i] = converter.int_value;
+            }
+            int_kernel().encrypt_span(out, count, out);
+        }
+
+        /**
+         *  Decrypts count values with this cipher's key in one pass, vectorized like
+         *  encrypt_n. The span is transformed chunk-wise into a scratch buffer and
+         *  unpacked through the converter.
+         */
+        void decrypt_n(const encrypted_type *encrypted, std::size_t count, value_type *out) const {
+            global_cipher_stats().record_decrypt(count);
+            auto kernel = int_kernel();
+            encrypted_type buffer[256];
+            for (std::size_t offset = 0; offset < count; offset += 256) {
+                auto chunk = count - offset < 256 ? count - offset : 256;
+                kernel.decrypt_span(encrypted + offset, chunk, buffer);
+                for (std::size_t i = 0; i < chunk; ++i) {
+                    converter converter;
+                    converter.int_value = buffer[i];
+                    out[offset + i] = converter.real_value;
+                }
+            }
+        }
+
     private:
         static constexpr encrypted_type LIMIT_MAX = std::numeric_limits<encrypted_type>::max();
         static constexpr encrypted_type LIMIT_MIN = std::numeric_limits<encrypted_type>::min();
@@ -201,6 +416,17 @@ namespace fe {
             _salt = dist(xor_cipher_value_random_engine_holder::get());
         }
 
+        /**
+         *  Builds an integer cipher over the same key and salt, whose vectorized span
+         *  kernels do the heavy lifting for the bulk paths above.
+         */
+        basic_int_xor_cipher<encrypted_type> int_kernel() const {
+            basic_int_xor_cipher<encrypted_type> kernel;
+            kernel._key = _key;
+            kernel._salt = _salt;
+            return kernel;
+        }
+
         union converter {
             value_type real_value;
             encrypted_type int_value;
@@ -208,6 +434,16 @@ namespace fe {
 
         encrypted_type _key;
         encrypted_type _salt;
+
+    protected:
+        /**
+         *  Copies the key material of the other instead of re-rolling it; for the
+         *  key-preserving policy classes (see fe::key_preserving_xor_cipher).
+         */
+        void copy_key_from(const basic_real_xor_cipher &other) noexcept {
+            _key = other._key;
+            _salt = other._salt;
+        }
     };
 
     template <class T>
@@ -254,6 +490,125 @@ namespace fe {
     template <>
     class xor_cipher<long double> : public basic_real_xor_cipher<long double, std::int_fast64_t> {};
 #endif
+
+    /**
+     *  Represents a xor cipher whose key and salt are shared by every instance for the
+     *  same value type, generated once per process. The cipher itself is empty, so a
+     *  cipher_value using it carries no per-instance cipher state and shrinks to just
+     *  its encrypted payload, restoring cache-line density in arrays of encrypted
+     *  values. Use fe::xor_cipher instead when every value must have its own key.
+     *
+     *  @tparam T The type of the unencrypted value.
+     */
+    template <class T>
+    class shared_xor_cipher {
+    public:
+        using value_type = T;
+        using encrypted_type = typename xor_cipher<T>::encrypted_type;
+
+        /**
+         *  Every instance shares one process-wide key, so copies trivially decrypt what
+         *  the original encrypted (see fe::preserves_key_on_copy).
+         */
+        using key_preserving_copy = std::true_type;
+
+        encrypted_type encrypt(const value_type &unencrypted) const {
+            return key_cipher().encrypt(unencrypted);
+        }
+
+        value_type decrypt(const encrypted_type &encrypted) const {
+            return key_cipher().decrypt(encrypted);
+        }
+
+        void encrypt_n(const value_type *unencrypted, std::size_t count, encrypted_type *out) const {
+            key_cipher().encrypt_n(unencrypted, count, out);
+        }
+
+        void decrypt_n(const encrypted_type *encrypted, std::size_t count, value_type *out) const {
+            key_cipher().decrypt_n(encrypted, count, out);
+        }
+
+    private:
+        static const xor_cipher<T> &key_cipher() {
+            static const xor_cipher<T> cipher;
+            return cipher;
+        }
+    };
+
+    /**
+     *  The Alias of cipher_value using the xor algorithm with a process-wide shared key
+     *  per value type.
+     *
+     *  @tparam T The type of the unencrypted value.
+     */
+    template <class T>
+    using shared_xor_cipher_value = cipher_value<T, shared_xor_cipher>;
+
+    /**
+     *  Represents a xor cipher with its own key per instance, like fe::xor_cipher, but
+     *  whose copies keep the key instead of re-rolling one. Copying a cipher_value using
+     *  this policy is then a plain struct copy with zero crypto work, which matters when
+     *  the values live inside reallocating containers. The trade-off is that a value and
+     *  all of its copies stay under one key for their whole lifetime; clone_rekeyed()
+     *  hands out a freshly keyed cipher where that is not wanted.
+     *
+     *  @tparam T The type of the unencrypted value.
+     */
+    template <class T>
+    class key_preserving_xor_cipher : public xor_cipher<T> {
+    public:
+        /**
+         *  Copies preserve the key (see fe::preserves_key_on_copy).
+         */
+        using key_preserving_copy = std::true_type;
+
+        /**
+         *  Default constructor. Generates a fresh key like fe::xor_cipher.
+         */
+        key_preserving_xor_cipher() = default;
+
+        /**
+         *  Copy constructor. Copies the key material of the other.
+         */
+        key_preserving_xor_cipher(const key_preserving_xor_cipher &other) : xor_cipher<T>() {
+            this->copy_key_from(other);
+        }
+
+        /**
+         *  Move constructor.
+         */
+        key_preserving_xor_cipher(key_preserving_xor_cipher &&other) noexcept = default;
+
+        /**
+         *  Copy assignment operator. Copies the key material of the other.
+         */
+        key_preserving_xor_cipher &operator=(const key_preserving_xor_cipher &other) {
+            this->copy_key_from(other);
+            return *this;
+        }
+
+        /**
+         *  Move assignment operator.
+         */
+        key_preserving_xor_cipher &operator=(key_preserving_xor_cipher &&other) noexcept = default;
+
+        /**
+         *  Returns an independently keyed cipher, for handing a copied value its own
+         *  fresh key where the key-preserving copy is not wanted.
+         */
+        key_preserving_xor_cipher clone_rekeyed() const {
+            return key_preserving_xor_cipher();
+        }
+    };
+
+    /**
+     *  The Alias of cipher_value using the xor algorithm whose copies keep the key, so
+     *  that copying the value is a plain struct copy.
+     *
+     *  @tparam T The type of the unencrypted value.
+     */
+    template <class T>
+    using key_preserving_xor_cipher_value = cipher_value<T, key_preserving_xor_cipher>;
 }
 
 #endif /* defined(__ferrum__xor_cipher_value__) */
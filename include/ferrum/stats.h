@@ -0,0 +1,255 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Daisuke Itabashi (https://github.com/idaisuke/ferrum)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef __ferrum__stats__
+#define __ferrum__stats__
+
+#include <cstdint>
+
+#if defined(FE_STATS)
+#include <atomic>
+#endif
+
+namespace fe {
+
+    /**
+     *  Represents a point-in-time reading of the instrumentation counters of one
+     *  container. All fields are zero unless the library is compiled with FE_STATS
+     *  defined.
+     */
+    struct container_stats_snapshot {
+        /**
+         *  The number of full container copies made by mutators.
+         */
+        std::uint64_t copies;
+
+        /**
+         *  The number of bytes of elements copied by those full copies.
+         */
+        std::uint64_t bytes_copied;
+
+        /**
+         *  The number of single-pass rebuilds, where a mutator built the new version
+         *  from scratch instead of copying the old one first.
+         */
+        std::uint64_t rebuilds;
+
+        /**
+         *  The number of versions published, counting in-place mutations as well as
+         *  copies and rebuilds.
+         */
+        std::uint64_t publications;
+
+        /**
+         *  The number of snapshots and pinned views taken.
+         */
+        std::uint64_t snapshots;
+    };
+
+    /**
+     *  Represents a point-in-time reading of the process-wide cipher counters.
+     *  All fields are zero unless the library is compiled with FE_STATS defined.
+     */
+    struct cipher_stats_snapshot {
+        /**
+         *  The number of calls into a cipher's encryption entry points.
+         */
+        std::uint64_t encrypt_calls;
+
+        /**
+         *  The number of calls into a cipher's decryption entry points.
+         */
+        std::uint64_t decrypt_calls;
+
+        /**
+         *  The number of values (or blocks, for the block kernels) encrypted; a bulk
+         *  call counts once in encrypt_calls and its whole span here.
+         */
+        std::uint64_t values_encrypted;
+
+        /**
+         *  The number of values (or blocks, for the block kernels) decrypted.
+         */
+        std::uint64_t values_decrypted;
+    };
+
+#if defined(FE_STATS)
+
+    /**
+     *  Provides the per-instance mutation-path counters of a container as relaxed
+     *  atomics, one relaxed increment per recorded operation. Containers hold this as
+     *  a private base so that the disabled variant below adds no per-instance state.
+     *
+     *  Copying or assigning a container starts the destination's counters at zero;
+     *  the counters describe one instance's history, not its contents.
+     */
+    class container_stats {
+    public:
+        container_stats() noexcept : _copies(0), _bytes_copied(0), _rebuilds(0), _publications(0), _snapshots(0) {
+        }
+
+        container_stats(const container_stats &) noexcept : container_stats() {
+        }
+
+        container_stats &operator=(const container_stats &) noexcept {
+            return *this;
+        }
+
+        void record_copy(std::uint64_t bytes) const noexcept {
+            _copies.fetch_add(1, std::memory_order_relaxed);
+            _bytes_copied.fetch_add(bytes, std::memory_order_relaxed);
+        }
+
+        void record_rebuild() const noexcept {
+            _rebuilds.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void record_publication() const noexcept {
+            _publications.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void record_snapshot() const noexcept {
+            _snapshots.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        /**
+         *  Reads every counter with relaxed loads. The fields are individually exact
+         *  but not a consistent cut across counters; good enough to scrape into a
+         *  metrics pipeline.
+         */
+        container_stats_snapshot read() const noexcept {
+            container_stats_snapshot snapshot;
+            snapshot.copies = _copies.load(std::memory_order_relaxed);
+            snapshot.bytes_copied = _bytes_copied.load(std::memory_order_relaxed);
+            snapshot.rebuilds = _rebuilds.load(std::memory_order_relaxed);
+            snapshot.publications = _publications.load(std::memory_order_relaxed);
+            snapshot.snapshots = _snapshots.load(std::memory_order_relaxed);
+            return snapshot;
+        }
+
+    private:
+        mutable std::atomic<std::uint64_t> _copies;
+        mutable std::atomic<std::uint64_t> _bytes_copied;
+        mutable std::atomic<std::uint64_t> _rebuilds;
+        mutable std::atomic<std::uint64_t> _publications;
+        mutable std::atomic<std::uint64_t> _snapshots;
+    };
+
+    /**
+     *  Provides the cipher call counters as relaxed atomics. The counters are
+     *  process-wide (see fe::global_cipher_stats) because the shared-key ciphers are
+     *  deliberately empty per instance and live inside payload-sized values.
+     */
+    class cipher_stats {
+    public:
+        cipher_stats() noexcept : _encrypt_calls(0), _decrypt_calls(0), _values_encrypted(0), _values_decrypted(0) {
+        }
+
+        cipher_stats(const cipher_stats &) = delete;
+        cipher_stats &operator=(const cipher_stats &) = delete;
+
+        void record_encrypt(std::uint64_t values) noexcept {
+            _encrypt_calls.fetch_add(1, std::memory_order_relaxed);
+            _values_encrypted.fetch_add(values, std::memory_order_relaxed);
+        }
+
+        void record_decrypt(std::uint64_t values) noexcept {
+            _decrypt_calls.fetch_add(1, std::memory_order_relaxed);
+            _values_decrypted.fetch_add(values, std::memory_order_relaxed);
+        }
+
+        /**
+         *  Reads every counter with relaxed loads; individually exact, not a
+         *  consistent cut.
+         */
+        cipher_stats_snapshot read() const noexcept {
+            cipher_stats_snapshot snapshot;
+            snapshot.encrypt_calls = _encrypt_calls.load(std::memory_order_relaxed);
+            snapshot.decrypt_calls = _decrypt_calls.load(std::memory_order_relaxed);
+            snapshot.values_encrypted = _values_encrypted.load(std::memory_order_relaxed);
+            snapshot.values_decrypted = _values_decrypted.load(std::memory_order_relaxed);
+            return snapshot;
+        }
+
+    private:
+        std::atomic<std::uint64_t> _encrypt_calls;
+        std::atomic<std::uint64_t> _decrypt_calls;
+        std::atomic<std::uint64_t> _values_encrypted;
+        std::atomic<std::uint64_t> _values_decrypted;
+    };
+
+#else
+
+    /**
+     *  The disabled variant compiled without FE_STATS: an empty base whose recording
+     *  methods are no-ops the optimizer removes, so instrumentation costs nothing
+     *  unless it is asked for.
+     */
+    class container_stats {
+    public:
+        void record_copy(std::uint64_t) const noexcept {
+        }
+
+        void record_rebuild() const noexcept {
+        }
+
+        void record_publication() const noexcept {
+        }
+
+        void record_snapshot() const noexcept {
+        }
+
+        container_stats_snapshot read() const noexcept {
+            return container_stats_snapshot();
+        }
+    };
+
+    /**
+     *  The disabled variant compiled without FE_STATS.
+     */
+    class cipher_stats {
+    public:
+        void record_encrypt(std::uint64_t) noexcept {
+        }
+
+        void record_decrypt(std::uint64_t) noexcept {
+        }
+
+        cipher_stats_snapshot read() const noexcept {
+            return cipher_stats_snapshot();
+        }
+    };
+
+#endif
+
+    /**
+     *  Returns the process-wide cipher counters. The ciphers record here instead of
+     *  per instance so that the empty shared-key policies stay empty and a
+     *  cipher_value stays the size of its payload even in instrumented builds.
+     */
+    inline cipher_stats &global_cipher_stats() noexcept {
+        static cipher_stats instance;
+        return instance;
+    }
+}
+
+#endif /* defined(__ferrum__stats__) */